@@ -0,0 +1,8 @@
+#include "eval3.hpp"
+
+int main(int argc, char ** argv) {
+  Story * story = buildStory(argc, argv);
+  printAllPathsCached(story);
+  delete story;
+  return EXIT_SUCCESS;
+}
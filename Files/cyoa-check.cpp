@@ -0,0 +1,8 @@
+#include "eval3.hpp"
+
+int main(int argc, char ** argv) {
+  if (!modelCheckStory(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
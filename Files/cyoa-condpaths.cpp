@@ -0,0 +1,7 @@
+#include "eval3.hpp"
+int main(int argc, char ** argv) {
+  Story * story = buildCondStory(argc, argv);
+  printCondPaths(story);
+  delete story;
+  return EXIT_SUCCESS;
+}
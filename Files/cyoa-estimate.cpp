@@ -0,0 +1,6 @@
+#include "eval3.hpp"
+
+int main(int argc, char ** argv) {
+  printPathEstimate(argc, argv);
+  return EXIT_SUCCESS;
+}
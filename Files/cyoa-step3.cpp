@@ -1,8 +1,6 @@
 #include "eval3.hpp"
 
 int main(int argc, char ** argv) {
-  Story * story = buildStory(argc, argv);
-  printAllPaths(story);
-  delete story;
+  printQueryPaths(argc, argv);
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,6 @@
+#include "eval3.hpp"
+
+int main(int argc, char ** argv) {
+  printZddPaths(argc, argv);
+  return EXIT_SUCCESS;
+}
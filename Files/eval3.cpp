@@ -15,7 +15,8 @@ Page:
       std::string closing: text displayed for end of page
       std::vector<std::string> choices: choices displayed for page
       std::vector<size_t> destpages: destination pages for choices of page
-      std::vector<int, std::pair<std::string, long int> > conditions: conditional choices for page
+      std::vector<ChoiceCond> conditions: conditional choices for page in choice order
+      std::vector<CondOp> code: postfix bytecode of conditions for page
 
       Methods
       -------
@@ -59,73 +60,76 @@ Page:
       std::string toString() const;
         - Convert contents for page to std::string
 
-      std::map<int, std::pair<std::string, long int> > & getConditions();
-      const std::map<int, std::pair<std::string, long int> > & getConditions() const;
+      std::vector<ChoiceCond> & getConditions();
+      const std::vector<ChoiceCond> & getConditions() const;
         - Return conditional choices for page
-        - int: choice number
-        - std::string: variable
-        - long int: variable value
+        - size_t choice: choice number
+        - size_t first: index of first instruction of condition in code
+        - size_t last: index past last instruction of condition in code
 
-      void setConditions(std::map<int, std::pair<std::string, long int> > & conds);
-        - Set conditional choices for page
+      const std::vector<CondOp> & getCode() const;
+        - Return bytecode of conditions for page
+        - int opcode: COND_EQ, COND_NE, COND_LT, or COND_GT comparing variable var to
+          value, or COND_AND or COND_OR joining the two results on top of the stack
+        - size_t var: variable id, or NO_VAR for a variable that is never declared
+        - long int value: value compared to
 
-      bool doesMatchExist(std::map<std::string, long int> & memory,
-                        std::string & var,
-                        long int val) const;
-        - Determines match among set variables and their current values among conditional choices for page
-          at time in adventure
+      void setConditions(std::vector<ChoiceCond> & conds, std::vector<CondOp> & ops);
+        - Set conditional choices for page and their bytecode
+
+      bool doesMatchExist(std::vector<long int> & memory, const ChoiceCond & cond) const;
+        - Determines whether condition of a conditional choice for page holds for set variables and
+          their current values at time in adventure; comparisons with undeclared variables never hold
 
         Arguments
         ---------
-          - std::map<std::string, long int> & memory:
-            - variables and their current values at time in adventure
-          - std::string & var:
-            - variable of conditional choice for page
-          - long int val:
-            - value of variable of conditional choice for page
+          - std::vector<long int> & memory:
+            - current value of each variable id at time in adventure
+          - const ChoiceCond & cond:
+            - conditional choice for page
 
         Return
         ------
           - indicates match for set variables and their current values among conditional choices for page
             at time in adventure
 
-      std::vector<std::string> process(std::map<std::string, long int> & memory) const;
+      std::vector<std::string> process(std::vector<long int> & memory) const;
       - Processes choices for page by selecting those displayed normally versus <UNAVAILABLE>
 
         Arguments
         ---------
-          - std::map<std::string, long int> & memory:
-            - variables and their current values at time in adventure
+          - std::vector<long int> & memory:
+            - current value of each variable id at time in adventure
 
         Return
         ------
           - processed choices displayed for page
 
-      std::vector<std::string> processChoices(std::map<std::string, long int> & memory) const;
-      - Wrapper function for std::vector<std::string> process(std::map<std::string, long int> & memory) const;
+      std::vector<std::string> processChoices(std::vector<long int> & memory) const;
+      - Wrapper function for std::vector<std::string> process(std::vector<long int> & memory) const;
 
         Arguments
         ---------
-          - std::map<std::string, long int> & memory:
-            - variables and their current values at time in adventure
+          - std::vector<long int> & memory:
+            - current value of each variable id at time in adventure
 
         Return
         ------
           - processed choices displayed for page
 
-      std::set<size_t> getInvalidChoices(std::map<std::string, long int> & memory) const;
+      std::set<size_t> getInvalidChoices(std::vector<long int> & memory) const;
       - Indicates which choices for page will display as <UNAVAILABLE> and cannot be selected
 
         Arguments
         ---------
-          - std::map<std::string, long int> & memory:
-            - variables and their current values at time in adventure
+          - std::vector<long int> & memory:
+            - current value of each variable id at time in adventure
 
         Return
         ------
           - numbers for choices for page that will display as <UNAVAILABLE>
 
-      std::string toStringCond(std::map<std::string, long int> & memory) const;
+      std::string toStringCond(std::vector<long int> & memory) const;
       - Convert contents for page to std::string for story with conditional choices
 
 Story:
@@ -135,7 +139,13 @@ Story:
       ----------
       std::map<size_t, Page *> pages: Page(s) of story
       std::vector<std::string> vars: variable declarations for story
-      std::map<std::string, long int> memory: variables and their current values at time in adventure
+      std::vector<std::string> varNames: variable for each variable id
+      std::map<std::string, size_t> varIds: variable id for each variable
+      std::vector<std::vector<std::pair<size_t, long int> > > assignments: variable id
+        and value of each variable declaration for each page number
+      std::vector<long int> memory: current value of each variable id at time in adventure
+      uint64_t validationKey: hash of story.txt file and page files used by validation cache
+      bool validated: indicates story passed validation on a previous run with same validationKey
 
       Methods
       -------
@@ -167,26 +177,410 @@ Story:
       void setVars(std::vector<std::string> & v);
         - Set variable declarations for story
 
-      std::vector<std::string> filterVars(size_t pagenum);
-        - Return variable declarations for size_t pagenum
-
       std::string parseVar(std::string & str);
         - Return std::string variable in variable declaration str
 
       long int parseVal(std::string & str);
         - Return long int value in variable declaration str
 
+      const std::vector<std::string> & getVarNames() const;
+        - Return variable for each variable id
+
+      size_t getVarId(const std::string & var) const;
+        - Return variable id for std::string var, or NO_VAR if it is never declared
+
       void buildMemory();
-        - Sets value of all story variables to zero
+        - Assign variable ids in order of first declaration, parse variable declarations
+          of each page, and set value of all story variables to zero
 
       void updateMemory(size_t pagenum);
         - Set variable value in memory to that in size_t pagenum variable declaration
 
-      std::map<std::string, long int> & getMemory();
-      const std::map<std::string, long int> & getMemory() const;
+      void updateMemory(size_t pagenum, std::vector<long int> & mem);
+        - Set variable value in std::vector<long int> & mem to that in size_t pagenum
+          variable declaration, leaving story memory unchanged
+
+      std::vector<long int> & getMemory();
+      const std::vector<long int> & getMemory() const;
         - Return current story memory
-        - std::string: variable
+        - size_t: variable id
         - long int: current value
+
+      uint64_t getValidationKey() const;
+      void setValidationKey(uint64_t key);
+        - Return/set hash of story.txt file and page files used by validation cache
+
+      bool isValidated() const;
+      void setValidated(bool flag);
+        - Return/set whether story passed validation on a previous run
+
+PathTrie:
+  A class to represent winnable paths in a story as a prefix trie so that shared
+  page sequences from page 0 are stored and printed once.
+
+      Attributes
+      ----------
+      std::vector<size_t> pages: page number for each trie node
+      std::vector<size_t> choices: choice number taken at parent node to reach each trie node
+      std::vector<size_t> ends: number of winnable paths ending at each trie node
+      std::vector<std::vector<size_t> > children: child trie nodes for each trie node
+
+      Methods
+      -------
+      PathTrie();
+        - Default class constructor with root node for page 0
+
+      ~PathTrie();
+        - Default class destructor
+
+      size_t size() const;
+        - Return number of trie nodes
+
+      size_t findChild(size_t node, size_t page) const;
+        - Return child trie node of size_t node for size_t page, or 0 if absent
+
+      void insert(Story * story, std::vector<size_t> & path);
+        - Add winnable page sequence std::vector<size_t> & path to trie
+
+      void write(std::ostream & out) const;
+        - Print trie as one line per node: <depth> <choice> <page>, followed by
+          number of winnable paths ending at node for end nodes
+
+PathIterator:
+  A class to enumerate winnable paths in a story one at a time, in the same order as
+  runDFS, with a cursor that can be saved to and restored from a checkpoint.
+
+      Attributes
+      ----------
+      Story * story: Choose-Your-Own-Adventure story
+      std::vector<size_t> winpages: page numbers of win pages
+      size_t winIdx: index in winpages of win page currently searched for
+      std::vector<size_t> path: current page sequence (DFS stack)
+      std::vector<size_t> remaining: number of unexplored choices for each page in path
+      size_t emitted: number of winnable paths returned so far
+
+      Methods
+      -------
+      PathIterator(Story * story);
+        - Class constructor with cursor at first winnable path
+
+      ~PathIterator();
+        - Default class destructor
+
+      void push(size_t pagenum);
+        - Append size_t pagenum to current page sequence
+
+      int next(std::vector<size_t> & out, size_t maxSteps);
+        - Advance cursor to next winnable path and copy it to out
+
+        Arguments
+        ---------
+          - std::vector<size_t> & out:
+            - winnable page sequence found
+          - size_t maxSteps:
+            - maximum number of pages to visit before returning (0 for no limit)
+
+        Return
+        ------
+          - 1 if winnable path found, 0 if enumeration is finished, -1 if maxSteps
+            reached before next winnable path
+
+      size_t getEmitted() const;
+        - Return number of winnable paths returned so far
+
+      bool isDone() const;
+        - Indicates if enumeration is finished
+
+      void save(std::ostream & out) const;
+        - Print cursor to std::ostream & out, headed by hashStory of story
+
+      bool load(std::istream & in);
+        - Restore cursor from std::istream & in, return false if cursor is invalid,
+          was saved for a story with a different hashStory, or records a page that
+          the choice on the page before it does not lead to
+
+StoryGraph:
+  A class to represent the pages and choices of a story as a compact adjacency array.
+  Pages are renumbered in breadth-first order from page 0 so that pages visited
+  together during traversal sit together in memory; page numbers are mapped back for
+  all output.
+
+      Attributes
+      ----------
+      std::vector<size_t> external: page number for each internal node
+      std::vector<size_t> internal: internal node for each page number, or NO_PAGE
+      std::vector<char> types: page type (N, W, or L) for each internal node
+      std::vector<size_t> first: index of first choice for each internal node (size nodes + 1)
+      std::vector<size_t> dests: internal destination node for each choice, or NO_PAGE
+        for a reference to a missing page
+      std::vector<size_t> predFirst: index of first predecessor for each internal node
+      std::vector<size_t> preds: internal source node of each choice leading to a node
+      std::vector<size_t> invalidRefs: destination page numbers of choices leading to
+        missing pages
+
+      Methods
+      -------
+      StoryGraph(Story * story);
+        - Class constructor renumbering pages of Story
+
+      ~StoryGraph();
+        - Default class destructor
+
+      size_t size() const;
+        - Return number of pages
+
+      size_t toExternal(size_t node) const;
+      size_t toInternal(size_t pagenum) const;
+        - Convert internal node to page number, and page number to internal node
+
+      char getType(size_t node) const;
+        - Return page type for internal node
+
+      size_t firstEdge(size_t node) const;
+      size_t lastEdge(size_t node) const;
+        - Return range of choice indices for internal node
+
+      size_t getDest(size_t edge) const;
+        - Return internal destination node for choice index
+
+      size_t firstPred(size_t node) const;
+      size_t lastPred(size_t node) const;
+        - Return range of predecessor indices for internal node
+
+      size_t getPred(size_t idx) const;
+        - Return internal source node for predecessor index
+
+      const std::vector<size_t> & getInvalidRefs() const;
+        - Return destination page numbers of choices leading to missing pages
+
+PathQuery:
+  A class to hold must-visit and must-avoid page constraints on winnable paths over
+  a story graph, with a reachability bitset per node so the search can cut branches
+  that can no longer visit every required page.
+
+      Attributes
+      ----------
+      std::vector<char> avoided: whether each node must be avoided
+      std::vector<size_t> required: index of each node among must-visit pages, or
+        NO_PAGE
+      size_t numRequired: number of must-visit pages
+      size_t words: number of 64-bit words in each reachability bitset
+      std::vector<uint64_t> reach: bitset of must-visit pages each node can reach
+        without crossing an avoided page (words per node)
+
+      Methods
+      -------
+      PathQuery(const StoryGraph & graph, std::vector<size_t> & must,
+                std::vector<size_t> & avoid);
+        - Class constructor computing reachability bitsets for page constraints
+
+      ~PathQuery();
+        - Default class destructor
+
+      bool isEmpty() const;
+        - Return true if there are no constraints
+
+      bool isAvoided(size_t node) const;
+        - Return true if size_t node must be avoided
+
+      size_t getRequired(size_t node) const;
+        - Return index of size_t node among must-visit pages, or NO_PAGE
+
+      std::vector<uint64_t> getPending() const;
+        - Return bitset with every must-visit page set
+
+      bool canReach(size_t node, const std::vector<uint64_t> & pending) const;
+        - Return true if size_t node can reach every page set in pending
+
+ChainGraph:
+  A class to represent a story graph with corridors of single-choice pages collapsed
+  into super-edges, used to enumerate winnable paths without stepping through each
+  corridor page.
+
+      Attributes
+      ----------
+      StoryGraph graph: renumbered story graph
+      std::vector<size_t> first: index of first super-edge for each node (size nodes + 1)
+      std::vector<size_t> dests: destination node for each super-edge
+      std::vector<size_t> viaFirst: index in via of first corridor node for each super-edge
+      std::vector<size_t> via: corridor nodes crossed by super-edges, in order
+
+      Methods
+      -------
+      ChainGraph(Story * story);
+        - Class constructor collapsing single-choice corridors of Story
+
+      ~ChainGraph();
+        - Default class destructor
+
+      size_t numEdges() const;
+        - Return number of super-edges
+
+      const StoryGraph & getGraph() const;
+        - Return renumbered story graph
+
+      size_t printPaths(Story * story, size_t to, std::ostream & out,
+                        const PathQuery * query = NULL) const;
+        - Print winnable paths from page 0 to win page size_t to, in the same order
+          as dfs, that satisfy page constraints in query, and return number of
+          paths printed
+
+SubgraphClasses:
+  A class to group pages whose reachable subgraphs are acyclic and structurally
+  identical (same page types and choices, recursively) into shared classes, so that
+  winnable paths below them are counted and pruned once per class.
+
+      Attributes
+      ----------
+      std::vector<size_t> classOf: class of each page, or NO_CLASS for pages that can
+        reach a cycle or are unreachable from page 0
+      std::vector<long double> counts: number of winnable paths from a page of each class
+      std::vector<size_t> liveFirst: index in live of first live choice for each class
+      std::vector<size_t> live: choice indices (0-based) leading to a winnable path
+
+      Methods
+      -------
+      SubgraphClasses(Story * story);
+        - Class constructor interning the acyclic subgraphs of Story
+
+      ~SubgraphClasses();
+        - Default class destructor
+
+      size_t numClasses() const;
+        - Return number of shared classes
+
+      size_t getClass(size_t pagenum) const;
+        - Return class of size_t pagenum
+
+      long double countPaths(Story * story) const;
+        - Return number of winnable paths from page 0
+
+      size_t printPaths(Story * story, std::ostream & out) const;
+        - Print winnable paths from page 0 to any win page and return number printed
+
+HintTable:
+  A class to hold, for each page, the next choice on a shortest route to a win page
+  and the number of choices on that route, found by one reverse BFS from all win
+  pages so hints are looked up in constant time.
+
+      Attributes
+      ----------
+      std::vector<uint32_t> distances: choices to nearest win page for each page
+        number, or NO_HINT if no win page can be reached
+      std::vector<uint32_t> choices: next choice number for each page number, or 0
+
+      Methods
+      -------
+      HintTable(Story * story);
+        - Class constructor running reverse BFS from every win page in Story
+
+      ~HintTable();
+        - Default class destructor
+
+      bool hasHint(size_t pagenum) const;
+        - Return true if a win page can be reached from size_t pagenum
+
+      size_t getChoice(size_t pagenum) const;
+        - Return next choice number on shortest route to win page from size_t pagenum
+
+      size_t getDistance(size_t pagenum) const;
+        - Return number of choices on shortest route to win page from size_t pagenum
+
+PathZdd:
+  A class to hold the set of winnable paths of a story graph as a zero-suppressed
+  decision diagram over its choices (edges), built with the frontier-based method so
+  that counting, membership and page filters work on the diagram without
+  enumerating paths. Node 0 is the empty set terminal and node 1 the terminal
+  holding only the empty set; every other node tests one edge, and its children
+  always have smaller ids.
+
+      Attributes
+      ----------
+      std::vector<size_t> vars: edge tested by each node
+      std::vector<size_t> los: child for sets without the edge
+      std::vector<size_t> his: child for sets with the edge
+      std::map<std::pair<size_t, std::pair<size_t, size_t> >, size_t> unique: node for
+        each (edge, lo, hi) so equal subdiagrams are shared
+      size_t root: node holding every winnable path
+
+      Methods
+      -------
+      PathZdd(StoryGraph & graph);
+        - Class constructor building winnable paths from page 0 of story graph
+
+      ~PathZdd();
+        - Default class destructor
+
+      size_t getRoot() const;
+        - Return node holding every winnable path
+
+      size_t size(size_t node) const;
+        - Return number of nodes below size_t node, including terminals
+
+      size_t makeNode(size_t var, size_t lo, size_t hi);
+        - Return shared node testing edge size_t var, or lo if hi is empty
+
+      std::string count(size_t node) const;
+        - Return exact number of sets below size_t node in decimal
+
+      bool contains(size_t node, std::vector<size_t> & edges) const;
+        - Return true if sorted edge set is below size_t node
+
+      size_t filter(size_t node, std::vector<char> & marked, bool keep);
+        - Return node holding sets below size_t node that contain a marked edge
+          (keep) or contain none (!keep)
+
+      void printPaths(Story * story, StoryGraph & graph, size_t node,
+                      std::ostream & out) const;
+        - Print every set below size_t node as a winnable path
+
+StateSpace:
+  A class to intern (page, memory) states of a conditional story. Each variable can
+  only hold 0 or a value some page assigns to it, so memory is stored as the index
+  of each value packed into as few bits as possible, and states are found by an
+  open-addressing hash table over the packed keys.
+
+      Attributes
+      ----------
+      std::vector<std::vector<long int> > values: sorted values each variable id can hold
+      std::vector<size_t> words: key word holding each variable id
+      std::vector<size_t> shifts: bit offset of each variable id in its key word
+      std::vector<size_t> bits: number of bits for each variable id, 0 for a variable
+      that only ever holds one value (not stored in the key)
+      size_t width: number of words in a key, the first holding the page number
+      std::vector<uint64_t> keys: key of each state, width words apart
+      std::vector<size_t> slots: hash table of states, NO_STATE where empty
+      std::vector<uint64_t> scratch: key being interned
+
+      Methods
+      -------
+      StateSpace(Story * story);
+        - Class constructor collecting values each variable of story can hold
+
+      ~StateSpace();
+        - Default class destructor
+
+      size_t size() const;
+        - Return number of states interned
+
+      size_t getWidth() const;
+        - Return number of words in a key
+
+      void encode(size_t pagenum, std::vector<long int> & memory, uint64_t * key) const;
+        - Write key of (pagenum, memory) to uint64_t * key
+
+      uint64_t hashKey(const uint64_t * key) const;
+        - Return hash of key
+
+      size_t intern(const uint64_t * key);
+      size_t intern(size_t pagenum, std::vector<long int> & memory);
+        - Return state for key or (pagenum, memory), adding it if it is new
+
+      size_t getPage(size_t state) const;
+        - Return page number of state
+
+      void getMemory(size_t state, std::vector<long int> & memory) const;
+        - Fill memory with variable values of state
 */
 
 #include "eval3.hpp"
@@ -294,57 +688,64 @@ std::string Page::toString() const {
   return ss.str();
 }
 
-std::map<int, std::pair<std::string, long int> > & Page::getConditions() {
+std::vector<ChoiceCond> & Page::getConditions() {
   return conditions;
 }
-const std::map<int, std::pair<std::string, long int> > & Page::getConditions() const {
+const std::vector<ChoiceCond> & Page::getConditions() const {
   return conditions;
 }
 
-void Page::setConditions(std::map<int, std::pair<std::string, long int> > & conds) {
+const std::vector<CondOp> & Page::getCode() const {
+  return code;
+}
+
+void Page::setConditions(std::vector<ChoiceCond> & conds, std::vector<CondOp> & ops) {
   conditions = conds;
+  code = ops;
 }
 
-bool Page::doesMatchExist(std::map<std::string, long int> & memory,
-                          std::string & var,
-                          long int val) const {
-  std::map<std::string, long int>::const_iterator it = memory.find(var);
-  if (it != memory.end() && it->second == val) {
-    return true;
+bool Page::doesMatchExist(std::vector<long int> & memory, const ChoiceCond & cond) const {
+  bool stack[COND_STACK_SIZE];
+  size_t top = 0;
+  for (size_t idx = cond.first; idx < cond.last; idx++) {
+    const CondOp & op = code[idx];
+    if (op.opcode == COND_AND) {
+      top--;
+      stack[top - 1] = stack[top - 1] && stack[top];
+      continue;
+    }
+    if (op.opcode == COND_OR) {
+      top--;
+      stack[top - 1] = stack[top - 1] || stack[top];
+      continue;
+    }
+    // comparisons with undeclared variables (id NO_VAR) are never true
+    bool match = op.var < memory.size();
+    if (match) {
+      long int val = memory[op.var];
+      match = (op.opcode == COND_EQ && val == op.value) ||
+              (op.opcode == COND_NE && val != op.value) ||
+              (op.opcode == COND_LT && val < op.value) ||
+              (op.opcode == COND_GT && val > op.value);
+    }
+    stack[top++] = match;
   }
-  return false;
+  return stack[0];
 }
 
-std::vector<std::string> Page::process(std::map<std::string, long int> & memory) const {
-  int choiceNum = 1;
-  std::vector<std::string> processed;
-  std::vector<std::string>::const_iterator it = choices.begin();
-  while (it != choices.end()) {
-    std::map<int, std::pair<std::string, long int> >::const_iterator condIt =
-        conditions.find(choiceNum);
-    if (condIt != conditions.end()) {
-      std::string var = condIt->second.first;
-      long int val = condIt->second.second;
-      bool match = doesMatchExist(memory, var, val);
-      if (match) {
-        processed.push_back(*it);
-      }
-      else {
-        std::string unavailable("<UNAVAILABLE>");
-        processed.push_back(unavailable);
-      }
-    }
-    else {
-      processed.push_back(*it);
+std::vector<std::string> Page::process(std::vector<long int> & memory) const {
+  std::vector<std::string> processed(choices);
+  std::vector<ChoiceCond>::const_iterator it = conditions.begin();
+  while (it != conditions.end()) {
+    if (!doesMatchExist(memory, *it)) {
+      processed[it->choice - 1] = "<UNAVAILABLE>";
     }
-    choiceNum++;
     ++it;
   }
   return processed;
 }
 
-std::vector<std::string> Page::processChoices(
-    std::map<std::string, long int> & memory) const {
+std::vector<std::string> Page::processChoices(std::vector<long int> & memory) const {
   if (!conditions.empty()) {
     std::vector<std::string> processed = process(memory);
     return processed;
@@ -352,22 +753,19 @@ std::vector<std::string> Page::processChoices(
   return choices;
 }
 
-std::set<size_t> Page::getInvalidChoices(std::map<std::string, long int> & memory) const {
-  std::vector<std::string> processed = processChoices(memory);
-  size_t choiceNum = 1;
+std::set<size_t> Page::getInvalidChoices(std::vector<long int> & memory) const {
   std::set<size_t> invalidChoices;
-  std::vector<std::string>::iterator it = processed.begin();
-  while (it != processed.end()) {
-    if (!it->compare("<UNAVAILABLE>")) {
-      invalidChoices.insert(choiceNum);
+  std::vector<ChoiceCond>::const_iterator it = conditions.begin();
+  while (it != conditions.end()) {
+    if (!doesMatchExist(memory, *it)) {
+      invalidChoices.insert(it->choice);
     }
-    choiceNum++;
     ++it;
   }
   return invalidChoices;
 }
 
-std::string Page::toStringCond(std::map<std::string, long int> & memory) const {
+std::string Page::toStringCond(std::vector<long int> & memory) const {
   std::stringstream ss;
   const std::vector<std::string> & text = getText();
   std::vector<std::string>::const_iterator it = text.begin();
@@ -392,10 +790,26 @@ std::string Page::toStringCond(std::map<std::string, long int> & memory) const {
 
 //======================================================================
 
-Story::Story() : pages(), vars() {
+Story::Story() :
+    pages(),
+    vars(),
+    varNames(),
+    varIds(),
+    assignments(),
+    memory(),
+    validationKey(0),
+    validated(false) {
 }
 
-Story::Story(std::map<size_t, Page *> pages) : pages(pages), vars() {
+Story::Story(std::map<size_t, Page *> pages) :
+    pages(pages),
+    vars(),
+    varNames(),
+    varIds(),
+    assignments(),
+    memory(),
+    validationKey(0),
+    validated(false) {
 }
 
 Story::~Story() {
@@ -444,20 +858,6 @@ void Story::setVars(std::vector<std::string> & v) {
   vars = v;
 }
 
-std::vector<std::string> Story::filterVars(size_t pagenum) {
-  std::vector<std::string> filteredVars;
-  std::vector<std::string>::const_iterator it = vars.begin();
-  while (it != vars.end()) {
-    std::string var = *it;
-    size_t pnum = getPagenum(var);
-    if (pagenum == pnum) {
-      filteredVars.push_back(*it);
-    }
-    ++it;
-  }
-  return filteredVars;
-}
-
 std::string Story::parseVar(std::string & str) {
   size_t pos = str.find("$");
   size_t pos2 = str.find("=");
@@ -474,33 +874,70 @@ long int Story::parseVal(std::string & str) {
   return val;
 }
 
+const std::vector<std::string> & Story::getVarNames() const {
+  return varNames;
+}
+
+size_t Story::getVarId(const std::string & var) const {
+  std::map<std::string, size_t>::const_iterator it = varIds.find(var);
+  return it == varIds.end() ? NO_VAR : it->second;
+}
+
 void Story::buildMemory() {
+  varNames.clear();
+  varIds = indexVars(vars, varNames);
+  memory.assign(varNames.size(), 0);
+  assignments.clear();
   std::vector<std::string>::iterator it = vars.begin();
   while (it != vars.end()) {
+    size_t pagenum = getPagenum(*it);
+    if (assignments.size() <= pagenum) {
+      assignments.resize(pagenum + 1);
+    }
     std::string var = parseVar(*it);
-    memory[var] = 0;
+    assignments[pagenum].push_back(std::make_pair(varIds[var], parseVal(*it)));
     ++it;
   }
 }
 
 void Story::updateMemory(size_t pagenum) {
-  std::vector<std::string> fvars = filterVars(pagenum);
-  std::vector<std::string>::iterator it = fvars.begin();
-  while (it != fvars.end()) {
-    std::string var = parseVar(*it);
-    long int val = parseVal(*it);
-    memory[var] = val;
+  updateMemory(pagenum, memory);
+}
+
+void Story::updateMemory(size_t pagenum, std::vector<long int> & mem) {
+  if (pagenum >= assignments.size()) {
+    return;
+  }
+  std::vector<std::pair<size_t, long int> >::iterator it = assignments[pagenum].begin();
+  while (it != assignments[pagenum].end()) {
+    mem[it->first] = it->second;
     ++it;
   }
 }
 
-std::map<std::string, long int> & Story::getMemory() {
+std::vector<long int> & Story::getMemory() {
   return memory;
 }
-const std::map<std::string, long int> & Story::getMemory() const {
+const std::vector<long int> & Story::getMemory() const {
   return memory;
 }
 
+uint64_t Story::getValidationKey() const {
+  return validationKey;
+}
+
+void Story::setValidationKey(uint64_t key) {
+  validationKey = key;
+}
+
+bool Story::isValidated() const {
+  return validated;
+}
+
+void Story::setValidated(bool flag) {
+  validated = flag;
+}
+
 // ERROR HANDLING
 void checkPath(std::string & path) {
   /*
@@ -871,126 +1308,162 @@ void checkEndPages(
   checkMembership(normalpages, data.second);
 }
 
-std::set<size_t> addDestpages(std::set<size_t> & members,
-                              std::vector<size_t> & candidates) {
+void checkInvalidRefs(StoryGraph & graph) {
   /*
-    Check destination page numbers (candidates) for membership in
-    processed destination page numbers (members)
+    Check destination page number validity
 
     Arguments
     ---------
-    std::set<size_t> & members: processed destination page numbers
-    std::vector<size_t> & candidates: destination page numbers
+    StoryGraph & graph: renumbered story graph
 
     Return
     ------
-    std::set<size_t> processed destination page numbers
+    None
   */
-  std::vector<size_t>::iterator it = candidates.begin();
-  while (it != candidates.end()) {
-    if (members.find(*it) == members.end()) {
-      members.insert(*it);
+  const std::vector<size_t> & invalidRefs = graph.getInvalidRefs();
+  size_t minRef = NO_PAGE;
+  std::vector<size_t>::const_iterator it = invalidRefs.begin();
+  while (it != invalidRefs.end()) {
+    if (*it != 0 && *it < minRef) {
+      minRef = *it;
     }
     ++it;
   }
-  return members;
+  if (minRef != NO_PAGE) {
+    std::cerr << "Invalid Page Reference: " << minRef << std::endl;
+    exit(EXIT_FAILURE);
+  }
 }
 
-void helpInvalidRefs(std::map<size_t, Page *> & pages, std::set<size_t> & references) {
+void checkMissingRefs(StoryGraph & graph) {
   /*
-    Helper function for checkInvalidRefs
+    Check story pages for reference
 
     Arguments
     ---------
-    std::map<size_t, Page *> & pages: Page(s) of story
-    std::set<size_t> & references: destination page numbers
+    StoryGraph & graph: renumbered story graph
 
     Return
     ------
     None
   */
-  std::set<size_t>::iterator it = references.begin();
-  while (it != references.end()) {
-    if (pages.find(*it) == pages.end() && *it != 0) {
-      std::cerr << "Invalid Page Reference: " << *it << std::endl;
-      exit(EXIT_FAILURE);
+  size_t minPage = NO_PAGE;
+  for (size_t node = 0; node < graph.size(); node++) {
+    size_t pagenum = graph.toExternal(node);
+    if (graph.firstPred(node) == graph.lastPred(node) && pagenum != 0 &&
+        pagenum < minPage) {
+      minPage = pagenum;
     }
-    ++it;
+  }
+  if (minPage != NO_PAGE) {
+    std::cerr << "Missing Reference: page " << minPage << " does not have a reference"
+              << std::endl;
+    exit(EXIT_FAILURE);
   }
 }
 
-void checkInvalidRefs(Story * story) {
+std::vector<bool> findReachable(StoryGraph & graph) {
   /*
-    Check destination page number validity
+    Return pages reachable from page 0
 
     Arguments
     ---------
-    Story * story: Choose-Your-Own-Adventure story
+    StoryGraph & graph: renumbered story graph
 
     Return
     ------
-    None
+    std::vector<bool> indicating for each internal node if it is reachable from page 0
   */
-  std::string normal("N");
-  std::set<size_t> normalpages = story->getPagetypes(normal);
-  std::map<size_t, Page *> pages = story->getPages();
-  std::set<size_t> destpages;
-  std::set<size_t>::iterator it = normalpages.begin();
-  while (it != normalpages.end()) {
-    std::vector<size_t> references = story->getPage(*it)->getDestpages();
-    destpages = addDestpages(destpages, references);
-    ++it;
+  std::vector<bool> reached(graph.size(), false);
+  std::vector<size_t> todo;
+  if (graph.size() > 0 && graph.toExternal(0) == 0) {
+    reached[0] = true;
+    todo.push_back(0);
+  }
+  while (!todo.empty()) {
+    size_t node = todo.back();
+    todo.pop_back();
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (!reached[dest]) {
+        reached[dest] = true;
+        todo.push_back(dest);
+      }
+    }
   }
-  helpInvalidRefs(pages, destpages);
+  return reached;
 }
 
-void helpMissingRefs(std::map<size_t, Page *> & pages, std::set<size_t> & references) {
+std::vector<bool> findCoreachable(StoryGraph & graph) {
   /*
-    Helper function for checkMissingRefs
+    Return pages from which a Win or Lose page can be reached
 
     Arguments
     ---------
-    std::map<size_t, Page *> & pages: Page(s) of story
-    std::set<size_t> & references: destination page numbers
+    StoryGraph & graph: renumbered story graph
 
     Return
     ------
-    None
+    std::vector<bool> indicating for each internal node if a Win or Lose page is
+    reachable from it
   */
-  std::map<size_t, Page *>::iterator it = pages.begin();
-  while (it != pages.end()) {
-    if (references.find(it->first) == references.end() && it->first != 0) {
-      std::cerr << "Missing Reference: page " << it->first << " does not have a reference"
-                << std::endl;
-      exit(EXIT_FAILURE);
+  std::vector<bool> reached(graph.size(), false);
+  std::vector<size_t> todo;
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (graph.getType(node) != 'N') {
+      reached[node] = true;
+      todo.push_back(node);
+    }
+  }
+  while (!todo.empty()) {
+    size_t node = todo.back();
+    todo.pop_back();
+    for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+      size_t pred = graph.getPred(idx);
+      if (!reached[pred]) {
+        reached[pred] = true;
+        todo.push_back(pred);
+      }
     }
-    ++it;
   }
+  return reached;
 }
 
-void checkMissingRefs(Story * story) {
+void checkReachability(StoryGraph & graph) {
   /*
-    Check story pages for reference
+    Check story pages for reachability from page 0 and for a reachable Win or Lose page
 
     Arguments
     ---------
-    Story * story: Choose-Your-Own-Adventure story
+    StoryGraph & graph: renumbered story graph
 
     Return
     ------
     None
   */
-  std::string normal("N");
-  std::set<size_t> normalpages = story->getPagetypes(normal);
-  std::map<size_t, Page *> pages = story->getPages();
-  std::set<size_t> destpages;
-  std::set<size_t>::iterator it = normalpages.begin();
-  while (it != normalpages.end()) {
-    std::vector<size_t> references = story->getPage(*it)->getDestpages();
-    destpages = addDestpages(destpages, references);
-    ++it;
+  std::vector<bool> reachable = findReachable(graph);
+  std::vector<bool> coreachable = findCoreachable(graph);
+  size_t unreachable = NO_PAGE;
+  size_t trap = NO_PAGE;
+  for (size_t node = 0; node < graph.size(); node++) {
+    size_t pagenum = graph.toExternal(node);
+    if (!reachable[node]) {
+      unreachable = std::min(unreachable, pagenum);
+    }
+    else if (!coreachable[node]) {
+      trap = std::min(trap, pagenum);
+    }
+  }
+  if (unreachable != NO_PAGE) {
+    std::cerr << "Unreachable Page: page " << unreachable
+              << " cannot be reached from page 0" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (trap != NO_PAGE) {
+    std::cerr << "Dead End: page " << trap << " cannot reach a Win or Lose page"
+              << std::endl;
+    exit(EXIT_FAILURE);
   }
-  helpMissingRefs(pages, destpages);
 }
 
 void checkNumEndPages(Story * story) {
@@ -1017,8 +1490,8 @@ void checkNumEndPages(Story * story) {
 
 void checkStory(Story * story) {
   /*
-    Check story pages for invalid references, missing references, and number of win
-    and lose pages
+    Check story pages for invalid references, missing references, number of win
+    and lose pages, unreachable pages, and pages that cannot reach a win or lose page
 
     Arguments
     ---------
@@ -1028,9 +1501,16 @@ void checkStory(Story * story) {
     ------
     None
   */
-  checkInvalidRefs(story);
-  checkMissingRefs(story);
+  if (story->isValidated()) {
+    return;
+  }
+  StoryGraph graph(story);
+  checkInvalidRefs(graph);
+  checkMissingRefs(graph);
   checkNumEndPages(story);
+  checkReachability(graph);
+  saveValidation(story->getValidationKey());
+  story->setValidated(true);
 }
 
 // PROCESS INPUT
@@ -1095,7 +1575,10 @@ std::string getPath(int numArgs, char ** inputs, std::string & file) {
   return path;
 }
 
-std::vector<std::string> readInfile(std::string & path, std::string & file, bool flag) {
+std::vector<std::string> readInfile(std::string & path,
+                                    std::string & file,
+                                    bool flag,
+                                    bool check) {
   /*
     Read contents of std::string & file located at std::string & path
 
@@ -1104,6 +1587,7 @@ std::vector<std::string> readInfile(std::string & path, std::string & file, bool
     std::string & path: path to std::string & file
     std::string & file: name of file
     bool flag: indicates check for story.txt file (true) or not (false)
+    bool check: indicates story.txt file validity is checked (true) or not (false)
 
     Return
     ------
@@ -1129,7 +1613,7 @@ std::vector<std::string> readInfile(std::string & path, std::string & file, bool
       inputs.push_back(input);
     }
   }
-  if (flag) {
+  if (flag && check) {
     checkStoryFile(inputs);
   }
   story.close();
@@ -1137,13 +1621,15 @@ std::vector<std::string> readInfile(std::string & path, std::string & file, bool
 }
 
 std::pair<std::vector<std::string>, std::vector<std::string> > parseStoryFile(
-    std::vector<std::string> & lines) {
+    std::vector<std::string> & lines,
+    bool check) {
   /*
     Extract page/choice declarations from story.txt file
 
     Arguments
     ---------
     std::vector<std::string> & lines: story file lines
+    bool check: indicates page/choice declaration validity is checked (true) or not (false)
 
     Return
     ------
@@ -1166,10 +1652,12 @@ std::pair<std::vector<std::string>, std::vector<std::string> > parseStoryFile(
   }
   std::pair<std::vector<std::string>, std::vector<std::string> > data =
       std::make_pair(declarations, choices);
-  checkDups(data.first);
-  checkDups(data.second);
-  checkEndPages(data);
-  checkPageSeq(data.first);
+  if (check) {
+    checkDups(data.first);
+    checkDups(data.second);
+    checkEndPages(data);
+    checkPageSeq(data.first);
+  }
   return data;
 }
 
@@ -1424,15 +1912,39 @@ Story * buildStory(int argc, char ** argv) {
     ------
     Story * to complete Choose-Your-Own-Adventure Story
   */
+  checkNumArgs(argc);
+  return buildStory(argv[1]);
+}
+
+Story * buildStory(char * dir) {
+  /*
+    Return complete Choose-Your-Own-Adventure Story in char * dir
+
+    Arguments
+    ---------
+    char * dir: directory with story.txt file
+
+    Return
+    ------
+    Story * to complete Choose-Your-Own-Adventure Story
+  */
   std::string storyfile("story.txt");
-  std::string path = getPath(argc, argv, storyfile);
+  std::string path = buildPath(dir, storyfile);
   std::vector<std::string> lines;
   checkPath(path);
-  lines = readInfile(path, storyfile, true);
+  lines = readInfile(path, storyfile, true, false);
+  std::string mode("N");
+  uint64_t key = hashValidation(dir, lines, mode);
+  bool validated = isValidated(key);
+  if (!validated) {
+    checkStoryFile(lines);
+  }
   std::pair<std::vector<std::string>, std::vector<std::string> > data =
-      parseStoryFile(lines);
-  std::map<size_t, Page *> pages = buildPages(argv[1], data.first, data.second);
+      parseStoryFile(lines, !validated);
+  std::map<size_t, Page *> pages = buildPages(dir, data.first, data.second);
   Story * story = new Story(pages);
+  story->setValidationKey(key);
+  story->setValidated(validated);
   return story;
 }
 
@@ -1486,6 +1998,7 @@ void playStory(Story * story) {
     None
   */
   initStory(story);
+  HintTable hints(story);
   bool flag = false;
   size_t prevPage = 0;
   std::string input;
@@ -1497,7 +2010,12 @@ void playStory(Story * story) {
     size_t max = page->getChoices().size();
     while (!std::cin.good() || errno == ERANGE || choice == 0 ||
            (choice < 1 || max < choice)) {
-      std::cout << "That is not a valid choice, please try again" << std::endl;
+      if (std::cin.good() && !input.compare("hint")) {
+        printHint(hints, prevPage);
+      }
+      else {
+        std::cout << "That is not a valid choice, please try again" << std::endl;
+      }
       std::cin.clear();
       input.clear();
       end = NULL;
@@ -1514,6 +2032,28 @@ void playStory(Story * story) {
   }
 }
 
+void printHint(HintTable & hints, size_t pagenum) {
+  /*
+    Print next choice on shortest route to a win page from size_t pagenum
+
+    Arguments
+    ---------
+    HintTable & hints: next choice and distance to win page for each page
+    size_t pagenum: number of current Page
+
+    Return
+    ------
+    None
+  */
+  if (hints.hasHint(pagenum)) {
+    std::cout << "Hint: choose " << hints.getChoice(pagenum) << " (win in "
+              << hints.getDistance(pagenum) << " choices)" << std::endl;
+  }
+  else {
+    std::cout << "Hint: no choice from this page leads to a win" << std::endl;
+  }
+}
+
 int getFrequency(std::vector<size_t> & currentPath, size_t currentNode) {
   /*
     Return frequency of size_t currentNode in std::vector<size_t> & currentPath
@@ -1650,17 +2190,35 @@ void printPath(Story * story, std::vector<size_t> & pages) {
     ------
     None
   */
-  std::vector<size_t>::iterator it = pages.begin();
-  std::string delim;
-  int idx = 0;
+  printPath(story, pages, std::cout);
+  std::cout.flush();
+}
+
+void printPath(Story * story, std::vector<size_t> & pages, std::ostream & out) {
+  /*
+    Print winnable path in Story for Win Page to std::ostream & out
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    std::vector<size_t> & pages: winning page sequence in Story for Win Page
+    std::ostream & out: stream to print path to
+
+    Return
+    ------
+    None
+  */
+  std::vector<size_t>::iterator it = pages.begin();
+  std::string delim;
+  int idx = 0;
   for (size_t i = 0; i < (pages.size() - 1); i++) {
     size_t choiceNum = getChoiceNum(story->getPage(*it), pages[idx + 1]);
-    std::cout << delim << (*it) << "(" << choiceNum << ")";
+    out << delim << (*it) << "(" << choiceNum << ")";
     delim = ",";
     idx++;
     ++it;
   }
-  std::cout << "," << pages.back() << "(win)" << std::endl;
+  out << "," << pages.back() << "(win)\n";
 }
 
 void printPagePaths(Story * story, std::map<int, std::vector<size_t> > & paths) {
@@ -1719,17 +2277,139 @@ void printAllPaths(Story * story) {
     ------
     None
   */
+  std::vector<size_t> must;
+  std::vector<size_t> avoid;
+  printAllPaths(story, must, avoid);
+}
+
+void printAllPaths(Story * story, std::vector<size_t> & must, std::vector<size_t> & avoid) {
+  /*
+    Print all winnable paths in Story for all Win Page(s) that visit every page in
+    must and no page in avoid
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    std::vector<size_t> & must: pages every printed path must visit
+    std::vector<size_t> & avoid: pages no printed path may visit
+
+    Return
+    ------
+    None
+  */
   checkStory(story);
-  std::map<int, std::map<int, std::vector<size_t> > > allPaths = runDFS(story);
-  if (doesPathExist(allPaths)) {
-    std::map<int, std::map<int, std::vector<size_t> > >::iterator it = allPaths.begin();
-    while (it != allPaths.end()) {
-      printPagePaths(story, it->second);
-      ++it;
+  ChainGraph graph(story);
+  PathQuery query(graph.getGraph(), must, avoid);
+  std::string win("W");
+  std::set<size_t> winpages = story->getPagetypes(win);
+  size_t numPaths = 0;
+  std::set<size_t>::iterator it = winpages.begin();
+  while (it != winpages.end()) {
+    numPaths += graph.printPaths(story, *it, std::cout, &query);
+    ++it;
+  }
+  if (numPaths == 0 && must.empty() && avoid.empty()) {
+    std::cout << "This story is unwinnable!\n";
+  }
+  else if (numPaths == 0) {
+    std::cout << "No winnable path meets these constraints!\n";
+  }
+  std::cout.flush();
+}
+
+void printQueryPaths(int argc, char ** argv) {
+  /*
+    Print all winnable paths in Story meeting page constraints given on the command
+    line
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - +<page>: page every printed path must visit (optional, repeatable)
+      - -<page>: page no printed path may visit (optional, repeatable)
+
+    Return
+    ------
+    None
+  */
+  if (argc < 2) {
+    std::cerr << "Usage: ./cyoa-step3 <dir> [+page] [-page] ...\n";
+    exit(EXIT_FAILURE);
+  }
+  std::vector<size_t> must;
+  std::vector<size_t> avoid;
+  for (int i = 2; i < argc; i++) {
+    if (!parseConstraint(argv[i], must, avoid)) {
+      std::cerr << "Invalid Constraint: " << argv[i] << std::endl;
+      exit(EXIT_FAILURE);
     }
   }
+  Story * story = buildStory(argv[1]);
+  checkConstraints(story, must, avoid);
+  printAllPaths(story, must, avoid);
+  delete story;
+}
+
+bool parseConstraint(char * arg, std::vector<size_t> & must, std::vector<size_t> & avoid) {
+  /*
+    Parse page constraint +<page> (must visit) or -<page> (must avoid)
+
+    Arguments
+    ---------
+    char * arg: command line argument
+    std::vector<size_t> & must: pages every path must visit
+    std::vector<size_t> & avoid: pages no path may visit
+
+    Return
+    ------
+    bool true if char * arg is a page constraint
+  */
+  if ((arg[0] != '+' && arg[0] != '-') || !isdigit(arg[1])) {
+    return false;
+  }
+  char * end = NULL;
+  errno = 0;
+  size_t pagenum = std::strtoul(arg + 1, &end, 10);
+  if (*end != '\0' || errno == ERANGE) {
+    return false;
+  }
+  if (arg[0] == '+') {
+    must.push_back(pagenum);
+  }
   else {
-    std::cout << "This story is unwinnable!" << std::endl;
+    avoid.push_back(pagenum);
+  }
+  return true;
+}
+
+void checkConstraints(Story * story,
+                      std::vector<size_t> & must,
+                      std::vector<size_t> & avoid) {
+  /*
+    Check that every constrained page is in Story
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    std::vector<size_t> & must: pages every path must visit
+    std::vector<size_t> & avoid: pages no path may visit
+
+    Return
+    ------
+    None
+  */
+  std::vector<size_t> pages(must);
+  pages.insert(pages.end(), avoid.begin(), avoid.end());
+  std::vector<size_t>::iterator it = pages.begin();
+  while (it != pages.end()) {
+    if (story->getPages().find(*it) == story->getPages().end()) {
+      std::cerr << "Invalid Constraint: page " << *it << " is not in the story"
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    ++it;
   }
 }
 
@@ -1794,18 +2474,22 @@ int checkCondChoice(std::string & str) {
     int indicating success (1) or failure (0) of conditional choice declaration validity
   */
   if (!checkPagenum(str)) {
-    std::string eqsign("=");
-    if (charCount(str, ':') == 2 && !checkFormat(str, eqsign)) {
+    if (charCount(str, ':') == 2) {
       if (charCount(str, '[') == 1 && charCount(str, ']') == 1) {
-        if (str.find("[") < str.find("]")) {
+        size_t left = str.find("[");
+        size_t right = str.find("]");
+        if (left < right && right < str.find_first_of(":")) {
           size_t pos = str.find_first_of(":");
           std::string substr = str.substr(pos + 1);
-          size_t pos2 = str.find(eqsign);
-          std::string substr2 = str.substr(pos2 + 1);
-          if (!checkVarValue(substr2) && !checkPagenum(substr)) {
-            if (str.find_first_of(":") != str.find_last_of(":")) {
-              return EXIT_SUCCESS;
-            }
+          std::string expr = str.substr(left + 1, right - left - 1);
+          std::map<std::string, size_t> varIds;
+          std::vector<CondOp> code;
+          if (!compileCondition(expr, varIds, code)) {
+            std::cerr << "Invalid Condition: " << expr << std::endl;
+            exit(EXIT_FAILURE);
+          }
+          if (!checkPagenum(substr)) {
+            return EXIT_SUCCESS;
           }
         }
       }
@@ -1857,7 +2541,10 @@ void checkCondStory(std::vector<std::string> & lines) {
   }
 }
 
-std::vector<std::string> readCondFile(std::string & path, std::string & file, bool flag) {
+std::vector<std::string> readCondFile(std::string & path,
+                                      std::string & file,
+                                      bool flag,
+                                      bool check) {
   /*
     Read contents of std::string & file located at std::string & path
 
@@ -1866,6 +2553,7 @@ std::vector<std::string> readCondFile(std::string & path, std::string & file, bo
     std::string & path: path to std::string & file
     std::string & file: name of file
     bool flag: indicates check for story.txt file (true) or not (false)
+    bool check: indicates story.txt file validity is checked (true) or not (false)
 
     Return
     ------
@@ -1891,7 +2579,7 @@ std::vector<std::string> readCondFile(std::string & path, std::string & file, bo
       inputs.push_back(input);
     }
   }
-  if (flag) {
+  if (flag && check) {
     checkCondStory(inputs);
   }
   story.close();
@@ -1941,13 +2629,15 @@ void checkParsing(std::map<std::string, std::vector<std::string> > & data) {
 }
 
 std::map<std::string, std::vector<std::string> > parseCondStory(
-    std::vector<std::string> & lines) {
+    std::vector<std::string> & lines,
+    bool check) {
   /*
     Extract page, variable, and choice declarations from conditional story.txt file
 
     Arguments
     ---------
     std::vector<std::string> & lines: conditional story file lines
+    bool check: indicates declaration validity is checked (true) or not (false)
 
     Return
     ------
@@ -1974,7 +2664,9 @@ std::map<std::string, std::vector<std::string> > parseCondStory(
   data["declarations"] = declarations;
   data["variables"] = variables;
   data["choices"] = choices;
-  checkParsing(data);
+  if (check) {
+    checkParsing(data);
+  }
   return data;
 }
 
@@ -1997,33 +2689,199 @@ long int getValue(std::string & str) {
   return value;
 }
 
-std::map<int, std::pair<std::string, long int> > parseConditions(
-    std::vector<std::string> & choices) {
+std::map<std::string, size_t> indexVars(std::vector<std::string> & vars,
+                                        std::vector<std::string> & names) {
+  /*
+    Return dense ids for variables in order of first declaration
+
+    Arguments
+    ---------
+    std::vector<std::string> & vars: variable declarations
+    std::vector<std::string> & names: filled with variable for each id
+
+    Return
+    ------
+    std::map<std::string, size_t> id for each variable
+  */
+  std::map<std::string, size_t> varIds;
+  std::string dsign("$");
+  std::vector<std::string>::iterator it = vars.begin();
+  while (it != vars.end()) {
+    std::string var = getVariable(*it, dsign);
+    if (varIds.find(var) == varIds.end()) {
+      varIds[var] = names.size();
+      names.push_back(var);
+    }
+    ++it;
+  }
+  return varIds;
+}
+
+std::string trimSpaces(const std::string & str) {
+  /*
+    Return std::string & str without leading and trailing spaces
+
+    Arguments
+    ---------
+    const std::string & str: string to trim
+
+    Return
+    ------
+    std::string trimmed string
+  */
+  size_t first = str.find_first_not_of(" \t");
+  if (first == std::string::npos) {
+    return std::string();
+  }
+  size_t last = str.find_last_not_of(" \t");
+  return str.substr(first, last - first + 1);
+}
+
+bool compileComparison(std::string & term,
+                       std::map<std::string, size_t> & varIds,
+                       std::vector<CondOp> & code) {
+  /*
+    Append bytecode for one comparison var=value, var!=value, var<value, or
+    var>value
+
+    Arguments
+    ---------
+    std::string & term: comparison
+    std::map<std::string, size_t> & varIds: id for each declared variable
+    std::vector<CondOp> & code: bytecode to append to
+
+    Return
+    ------
+    bool false if term is not a valid comparison
+  */
+  size_t pos = term.find_first_of("!<>=");
+  if (pos == std::string::npos) {
+    return false;
+  }
+  CondOp op;
+  size_t length = 1;
+  if (term[pos] == '!') {
+    if (term.compare(pos, 2, "!=") != 0) {
+      return false;
+    }
+    op.opcode = COND_NE;
+    length = 2;
+  }
+  else {
+    op.opcode = term[pos] == '<' ? COND_LT : term[pos] == '>' ? COND_GT : COND_EQ;
+  }
+  std::string var = trimSpaces(term.substr(0, pos));
+  std::string value = trimSpaces(term.substr(pos + length));
+  if (var.empty() || value.empty()) {
+    return false;
+  }
+  char * end = NULL;
+  errno = 0;
+  op.value = std::strtol(value.c_str(), &end, 10);
+  if (errno == ERANGE || *end != '\0') {
+    return false;
+  }
+  std::map<std::string, size_t>::iterator idIt = varIds.find(var);
+  op.var = idIt == varIds.end() ? NO_VAR : idIt->second;
+  code.push_back(op);
+  return true;
+}
+
+bool compileCondition(std::string & expr,
+                      std::map<std::string, size_t> & varIds,
+                      std::vector<CondOp> & code) {
+  /*
+    Append postfix bytecode for a choice condition: comparisons joined by && and ||,
+    with && binding tighter, such as key=1 && door!=0 || gold>10
+
+    Arguments
+    ---------
+    std::string & expr: condition between [ and ] of a choice declaration
+    std::map<std::string, size_t> & varIds: id for each declared variable
+    std::vector<CondOp> & code: bytecode to append to
+
+    Return
+    ------
+    bool false if expr is not a valid condition
+  */
+  CondOp joiner;
+  joiner.var = NO_VAR;
+  joiner.value = 0;
+  size_t start = 0;
+  bool firstOr = true;
+  while (true) {
+    size_t orPos = expr.find("||", start);
+    std::string conj =
+        expr.substr(start, orPos == std::string::npos ? orPos : orPos - start);
+    size_t termStart = 0;
+    bool firstAnd = true;
+    while (true) {
+      size_t andPos = conj.find("&&", termStart);
+      std::string term = conj.substr(
+          termStart, andPos == std::string::npos ? andPos : andPos - termStart);
+      if (term.find_first_of("&|") != std::string::npos ||
+          !compileComparison(term, varIds, code)) {
+        return false;
+      }
+      if (!firstAnd) {
+        joiner.opcode = COND_AND;
+        code.push_back(joiner);
+      }
+      firstAnd = false;
+      if (andPos == std::string::npos) {
+        break;
+      }
+      termStart = andPos + 2;
+    }
+    if (!firstOr) {
+      joiner.opcode = COND_OR;
+      code.push_back(joiner);
+    }
+    firstOr = false;
+    if (orPos == std::string::npos) {
+      return true;
+    }
+    start = orPos + 2;
+  }
+}
+
+std::vector<ChoiceCond> parseConditions(std::vector<std::string> & choices,
+                                        std::map<std::string, size_t> & varIds,
+                                        std::vector<CondOp> & code) {
   /*
-    Return conditional choices among std::vector<std::string> & choices
+    Return conditional choices among std::vector<std::string> & choices, in choice
+    order, with their conditions compiled to bytecode
 
     Arguments
     ---------
     std::vector<std::string> & choice: choice declarations
+    std::map<std::string, size_t> & varIds: id for each declared variable
+    std::vector<CondOp> & code: filled with bytecode of every condition
 
     Return
     ------
-    std::map<int, std::pair<std::string, long int> > conditional choices among choices
-    - int: choice number
-    - std::pair
-      - std::string: variable
-      - long int: variable value
+    std::vector<ChoiceCond> conditional choices among choices
+    - size_t choice: choice number
+    - size_t first: index of first instruction of condition in code
+    - size_t last: index past last instruction of condition in code
   */
-  std::map<int, std::pair<std::string, long int> > conditions;
-  int choiceNum = 1;
+  std::vector<ChoiceCond> conditions;
+  size_t choiceNum = 1;
   std::vector<std::string>::iterator it = choices.begin();
   while (it != choices.end()) {
-    if (it->find("[") != it->npos) {
-      std::string leftBracket("[");
-      std::string variable = getVariable(*it, leftBracket);
-      long int value = getValue(*it);
-      std::pair<std::string, long int> data = std::make_pair(variable, value);
-      conditions[choiceNum] = data;
+    size_t left = it->find("[");
+    if (left != it->npos) {
+      size_t right = it->find("]");
+      std::string expr = it->substr(left + 1, right - left - 1);
+      ChoiceCond cond;
+      cond.choice = choiceNum;
+      cond.first = code.size();
+      if (!compileCondition(expr, varIds, code)) {
+        std::cerr << "Invalid Condition: " << expr << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      cond.last = code.size();
+      conditions.push_back(cond);
     }
     choiceNum++;
     ++it;
@@ -2036,7 +2894,8 @@ Page * matchCondChoices(size_t pagenum,
                         std::string & file,
                         std::vector<std::string> & text,
                         std::string & closing,
-                        std::vector<std::string> & choices) {
+                        std::vector<std::string> & choices,
+                        std::map<std::string, size_t> & varIds) {
   /*
     Return Page with matching std::vector<std::string> & choices in conditional story
 
@@ -2048,6 +2907,7 @@ Page * matchCondChoices(size_t pagenum,
     std::vector<std::string> & text: text displayed for page
     std::string & closing: closing text displayed for page
     std::vector<std::string> & choices: choice declarations
+    std::map<std::string, size_t> & varIds: id for each declared variable
 
     Return
     ------
@@ -2055,20 +2915,21 @@ Page * matchCondChoices(size_t pagenum,
   */
   std::vector<std::string> matchingChoices = parseChoices(choices, pagenum);
   std::vector<size_t> destpages = parseDestpages(matchingChoices);
-  std::map<int, std::pair<std::string, long int> > choiceConds =
-      parseConditions(matchingChoices);
+  std::vector<CondOp> code;
+  std::vector<ChoiceCond> choiceConds = parseConditions(matchingChoices, varIds, code);
   std::vector<std::string> parsedChoices = parseChoiceText(matchingChoices);
   Page * page =
       new Page(pagenum, pagetype, file, text, closing, parsedChoices, destpages);
   if (!choiceConds.empty()) {
-    page->setConditions(choiceConds);
+    page->setConditions(choiceConds, code);
   }
   return page;
 }
 
 Page * buildCondPage(char * dir,
                      std::string & declaration,
-                     std::vector<std::string> & choices) {
+                     std::vector<std::string> & choices,
+                     std::map<std::string, size_t> & varIds) {
   /*
     Return complete story Page for std::string & declaration in conditional story
 
@@ -2077,6 +2938,7 @@ Page * buildCondPage(char * dir,
     char * dir: directory with Choose-Your-Own-Adventure
     std::string & declaration: page declaration
     std::vector<std::string> & choices: choice declarations
+    std::map<std::string, size_t> & varIds: id for each declared variable
 
     Return
     ------
@@ -2088,14 +2950,16 @@ Page * buildCondPage(char * dir,
   std::string path = buildPath(dir, file);
   std::vector<std::string> text = readInfile(path, file, false);
   std::string closing = createClosing(pagetype);
-  Page * page = matchCondChoices(pagenum, pagetype, file, text, closing, choices);
+  Page * page =
+      matchCondChoices(pagenum, pagetype, file, text, closing, choices, varIds);
   checkMalloc(page);
   return page;
 }
 
 std::map<size_t, Page *> buildCondPages(char * dir,
                                         std::vector<std::string> & declarations,
-                                        std::vector<std::string> & choices) {
+                                        std::vector<std::string> & choices,
+                                        std::map<std::string, size_t> & varIds) {
   /*
     Return complete Page(s) for conditional story
 
@@ -2104,6 +2968,7 @@ std::map<size_t, Page *> buildCondPages(char * dir,
     char * dir: directory with Choose-Your-Own-Adventure
     std::vector<std::string> & declarations: page declarations
     std::vector<std::string> & choices: choice declarations
+    std::map<std::string, size_t> & varIds: id for each declared variable
 
     Return
     ------
@@ -2113,7 +2978,7 @@ std::map<size_t, Page *> buildCondPages(char * dir,
   Page * page = NULL;
   std::vector<std::string>::iterator it = declarations.begin();
   while (it != declarations.end()) {
-    page = buildCondPage(dir, *it, choices);
+    page = buildCondPage(dir, *it, choices, varIds);
     if (page != NULL) {
       pages[page->getPagenum()] = page;
     }
@@ -2135,17 +3000,44 @@ Story * buildCondStory(int argc, char ** argv) {
     ------
     Story * to complete Choose-Your-Own-Adventure Story
   */
+  checkNumArgs(argc);
+  return buildCondStory(argv[1]);
+}
+
+Story * buildCondStory(char * dir) {
+  /*
+    Return complete Conditional Choose-Your-Own-Adventure Story in char * dir
+
+    Arguments
+    ---------
+    char * dir: directory with story.txt file
+
+    Return
+    ------
+    Story * to complete Choose-Your-Own-Adventure Story
+  */
   std::string file("story.txt");
-  std::string path = getPath(argc, argv, file);
+  std::string path = buildPath(dir, file);
   std::vector<std::string> lines;
   checkPath(path);
-  lines = readCondFile(path, file, true);
-  std::map<std::string, std::vector<std::string> > data = parseCondStory(lines);
+  lines = readCondFile(path, file, true, false);
+  std::string mode("C");
+  uint64_t key = hashValidation(dir, lines, mode);
+  bool validated = isValidated(key);
+  if (!validated) {
+    checkCondStory(lines);
+  }
+  std::map<std::string, std::vector<std::string> > data =
+      parseCondStory(lines, !validated);
+  std::vector<std::string> names;
+  std::map<std::string, size_t> varIds = indexVars(data["variables"], names);
   std::map<size_t, Page *> pages =
-      buildCondPages(argv[1], data["declarations"], data["choices"]);
+      buildCondPages(dir, data["declarations"], data["choices"], varIds);
   Story * story = new Story(pages);
   story->setVars(data["variables"]);
   story->buildMemory();
+  story->setValidationKey(key);
+  story->setValidated(validated);
   return story;
 }
 
@@ -2198,3 +3090,4784 @@ void playCondStory(Story * story) {
     input.clear();
   }
 }
+
+//======================================================================
+
+PathTrie::PathTrie() : pages(1, 0), choices(1, 0), ends(1, 0), children(1) {
+}
+
+PathTrie::~PathTrie() {
+}
+
+size_t PathTrie::size() const {
+  return pages.size();
+}
+
+size_t PathTrie::findChild(size_t node, size_t page) const {
+  std::vector<size_t>::const_iterator it = children[node].begin();
+  while (it != children[node].end()) {
+    if (pages[*it] == page) {
+      return *it;
+    }
+    ++it;
+  }
+  return 0;
+}
+
+void PathTrie::insert(Story * story, std::vector<size_t> & path) {
+  size_t node = 0;
+  for (size_t i = 1; i < path.size(); i++) {
+    size_t child = findChild(node, path[i]);
+    if (child == 0) {
+      child = pages.size();
+      pages.push_back(path[i]);
+      choices.push_back(getChoiceNum(story->getPage(path[i - 1]), path[i]));
+      ends.push_back(0);
+      children.push_back(std::vector<size_t>());
+      children[node].push_back(child);
+    }
+    node = child;
+  }
+  ends[node]++;
+}
+
+void PathTrie::write(std::ostream & out) const {
+  std::stack<std::pair<size_t, size_t> > todo;
+  todo.push(std::make_pair(0, 0));
+  while (!todo.empty()) {
+    size_t node = todo.top().first;
+    size_t depth = todo.top().second;
+    todo.pop();
+    out << depth << " " << choices[node] << " " << pages[node];
+    if (ends[node] > 0) {
+      out << " " << ends[node];
+    }
+    out << "\n";
+    std::vector<size_t>::const_reverse_iterator it = children[node].rbegin();
+    while (it != children[node].rend()) {
+      todo.push(std::make_pair(*it, depth + 1));
+      ++it;
+    }
+  }
+}
+
+// PATH TRIE
+void printPathTrie(Story * story) {
+  /*
+    Print all winnable paths in Story for all Win Page(s) as a prefix trie, adding
+    each path to the trie as the search finds it so only the trie is kept in memory
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    None
+  */
+  checkStory(story);
+  PathTrie trie;
+  PathIterator cursor(story);
+  std::vector<size_t> path;
+  while (cursor.next(path, 0) == 1) {
+    trie.insert(story, path);
+  }
+  std::cout << "cyoa-trie\n";
+  if (cursor.getEmitted() > 0) {
+    trie.write(std::cout);
+  }
+  std::cout.flush();
+}
+
+void printTriePath(std::ostream & out,
+                   std::vector<size_t> & pages,
+                   std::vector<size_t> & choices) {
+  /*
+    Print winnable path decoded from prefix trie in the same format as printPath
+
+    Arguments
+    ---------
+    std::ostream & out: stream to print path to
+    std::vector<size_t> & pages: winning page sequence
+    std::vector<size_t> & choices: choice number taken to reach each page in pages
+
+    Return
+    ------
+    None
+  */
+  std::string delim;
+  for (size_t i = 0; i < (pages.size() - 1); i++) {
+    out << delim << pages[i] << "(" << choices[i + 1] << ")";
+    delim = ",";
+  }
+  out << "," << pages.back() << "(win)\n";
+}
+
+void decodePathTrie(std::istream & in, std::ostream & out) {
+  /*
+    Expand prefix trie printed by printPathTrie into winnable paths
+
+    Arguments
+    ---------
+    std::istream & in: stream with prefix trie
+    std::ostream & out: stream to print winnable paths to
+
+    Return
+    ------
+    None
+  */
+  std::string line;
+  if (!getline(in, line) || line.compare("cyoa-trie") != 0) {
+    std::cerr << "Invalid Trie Header: " << line << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  bool flag = false;
+  std::vector<size_t> pages;
+  std::vector<size_t> choices;
+  while (getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::stringstream ss(line);
+    size_t depth = 0;
+    size_t choice = 0;
+    size_t page = 0;
+    size_t count = 0;
+    if (!(ss >> depth >> choice >> page) || depth > pages.size()) {
+      std::cerr << "Invalid Trie Line: " << line << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    pages.resize(depth);
+    choices.resize(depth);
+    pages.push_back(page);
+    choices.push_back(choice);
+    if (ss >> count) {
+      for (size_t i = 0; i < count; i++) {
+        printTriePath(out, pages, choices);
+      }
+      flag = true;
+    }
+  }
+  if (!flag) {
+    out << "This story is unwinnable!\n";
+  }
+  out.flush();
+}
+
+void printDecodedTrie(int argc, char ** argv) {
+  /*
+    Print winnable paths from prefix trie file named on command line
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+
+    Return
+    ------
+    None
+  */
+  if (argc != 2) {
+    std::cerr << "Usage: ./cyoa-untrie <trie file>\n";
+    exit(EXIT_FAILURE);
+  }
+  std::string file(argv[1]);
+  std::ifstream infile(file.c_str());
+  checkInfile(infile, file);
+  decodePathTrie(infile, std::cout);
+  infile.close();
+}
+
+//======================================================================
+
+PathIterator::PathIterator(Story * story) :
+    story(story),
+    winpages(),
+    winIdx(0),
+    path(),
+    remaining(),
+    emitted(0) {
+  std::string win("W");
+  std::set<size_t> pagetypes = story->getPagetypes(win);
+  winpages.assign(pagetypes.begin(), pagetypes.end());
+}
+
+PathIterator::~PathIterator() {
+}
+
+void PathIterator::push(size_t pagenum) {
+  path.push_back(pagenum);
+  const std::vector<size_t> & destpages = story->getPage(pagenum)->getDestpages();
+  if (!destpages.empty() && getFrequency(path, pagenum) < 2) {
+    remaining.push_back(destpages.size());
+  }
+  else {
+    remaining.push_back(0);
+  }
+}
+
+int PathIterator::next(std::vector<size_t> & out, size_t maxSteps) {
+  size_t steps = 0;
+  while (winIdx < winpages.size()) {
+    if (path.empty()) {
+      push(0);
+      if (winpages[winIdx] == 0) {
+        out = path;
+        emitted++;
+        return 1;
+      }
+    }
+    while (!path.empty()) {
+      if (maxSteps != 0 && steps == maxSteps) {
+        return -1;
+      }
+      steps++;
+      if (remaining.back() > 0) {
+        size_t choice = --remaining.back();
+        size_t destpage = story->getPage(path.back())->getDestpages()[choice];
+        push(destpage);
+        if (destpage == winpages[winIdx]) {
+          out = path;
+          emitted++;
+          return 1;
+        }
+      }
+      else {
+        path.pop_back();
+        remaining.pop_back();
+      }
+    }
+    winIdx++;
+  }
+  return 0;
+}
+
+size_t PathIterator::getEmitted() const {
+  return emitted;
+}
+
+bool PathIterator::isDone() const {
+  return winIdx >= winpages.size();
+}
+
+void PathIterator::save(std::ostream & out) const {
+  out << "cyoa-cursor " << std::hex << hashStory(story) << std::dec << " " << winIdx << " "
+      << emitted << " " << path.size() << "\n";
+  for (size_t i = 0; i < path.size(); i++) {
+    out << path[i] << " " << remaining[i] << "\n";
+  }
+}
+
+bool PathIterator::load(std::istream & in) {
+  std::string header;
+  uint64_t hash = 0;
+  size_t idx = 0;
+  size_t count = 0;
+  size_t depth = 0;
+  if (!(in >> header >> std::hex >> hash >> std::dec >> idx >> count >> depth) ||
+      header.compare("cyoa-cursor") != 0 || hash != hashStory(story) ||
+      idx > winpages.size()) {
+    return false;
+  }
+  std::vector<size_t> pages;
+  std::vector<size_t> choices;
+  std::map<size_t, Page *> & storyPages = story->getPages();
+  for (size_t i = 0; i < depth; i++) {
+    size_t pagenum = 0;
+    size_t choice = 0;
+    if (!(in >> pagenum >> choice) || storyPages.find(pagenum) == storyPages.end() ||
+        choice > storyPages[pagenum]->getDestpages().size()) {
+      return false;
+    }
+    // each page must be reached by the choice recorded on the page before it
+    if (i == 0 ? pagenum != 0
+               : choices.back() >= storyPages[pages.back()]->getDestpages().size() ||
+                     storyPages[pages.back()]->getDestpages()[choices.back()] != pagenum) {
+      return false;
+    }
+    pages.push_back(pagenum);
+    choices.push_back(choice);
+  }
+  winIdx = idx;
+  emitted = count;
+  path = pages;
+  remaining = choices;
+  return true;
+}
+
+// RESUMABLE PATHS
+void saveCursor(PathIterator & cursor, std::string & file) {
+  /*
+    Write cursor to checkpoint std::string & file, replacing it atomically
+
+    Arguments
+    ---------
+    PathIterator & cursor: path enumeration cursor
+    std::string & file: name of checkpoint file
+
+    Return
+    ------
+    None
+  */
+  std::string tmpfile = getTempFile(file);
+  std::ofstream outfile(tmpfile.c_str());
+  cursor.save(outfile);
+  outfile.close();
+  if (!outfile.good() || std::rename(tmpfile.c_str(), file.c_str()) != 0) {
+    std::cerr << "Failed to write checkpoint " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+void loadCursor(PathIterator & cursor, std::string & file) {
+  /*
+    Restore cursor from checkpoint std::string & file if it exists
+
+    Arguments
+    ---------
+    PathIterator & cursor: path enumeration cursor
+    std::string & file: name of checkpoint file
+
+    Return
+    ------
+    None
+  */
+  std::ifstream infile(file.c_str());
+  if (!infile.good()) {
+    return;
+  }
+  if (!cursor.load(infile)) {
+    std::cerr << "Invalid Checkpoint: " << file
+              << " is corrupt or was written for a different story" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  infile.close();
+}
+
+void printResumedPaths(int argc, char ** argv) {
+  /*
+    Print winnable paths in Story, resuming from and periodically writing to a
+    checkpoint file, stopping after an optional number of paths
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: checkpoint file
+      - argv[3]: maximum number of paths to print (optional)
+
+    Return
+    ------
+    None
+  */
+  if (argc != 3 && argc != 4) {
+    std::cerr << "Usage: ./cyoa-resume <dir> <checkpoint> [limit]\n";
+    exit(EXIT_FAILURE);
+  }
+  size_t limit = 0;
+  if (argc == 4) {
+    limit = parseCount(argv[3]);
+  }
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  std::string file(argv[2]);
+  PathIterator cursor(story);
+  loadCursor(cursor, file);
+  std::vector<size_t> path;
+  size_t printed = 0;
+  time_t lastSave = time(NULL);
+  int status = 1;
+  while ((limit == 0 || printed < limit) &&
+         (status = cursor.next(path, CHECKPOINT_STEPS)) != 0) {
+    if (status == 1) {
+      printPath(story, path);
+      printed++;
+    }
+    if (time(NULL) - lastSave >= CHECKPOINT_SECONDS) {
+      saveCursor(cursor, file);
+      lastSave = time(NULL);
+    }
+  }
+  if (cursor.isDone() && cursor.getEmitted() == 0) {
+    std::cout << "This story is unwinnable!" << std::endl;
+  }
+  saveCursor(cursor, file);
+  delete story;
+}
+
+// PATH CACHE
+uint64_t hashStory(Story * story) {
+  /*
+    Return FNV-1a hash of Story graph structure (page numbers, page types, and
+    destination pages)
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    uint64_t hash of Story graph structure
+  */
+  std::stringstream ss;
+  std::map<size_t, Page *> & pages = story->getPages();
+  std::map<size_t, Page *>::iterator it = pages.begin();
+  while (it != pages.end()) {
+    ss << it->first << "@" << it->second->getPagetype() << ":";
+    std::vector<size_t> & destpages = it->second->getDestpages();
+    std::vector<size_t>::iterator destIt = destpages.begin();
+    while (destIt != destpages.end()) {
+      ss << *destIt << ",";
+      ++destIt;
+    }
+    ss << "\n";
+    ++it;
+  }
+  return hashString(ss.str());
+}
+
+uint64_t hashString(const std::string & str) {
+  /*
+    Return FNV-1a hash of std::string & str
+
+    Arguments
+    ---------
+    const std::string & str: string to hash
+
+    Return
+    ------
+    uint64_t hash of str
+  */
+  uint64_t hash = FNV_OFFSET;
+  for (size_t i = 0; i < str.size(); i++) {
+    hash ^= (unsigned char)str[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+std::string getCacheDir() {
+  /*
+    Return cache directory named by CYOA_CACHE_DIR (default .cyoa-cache), creating
+    it if absent; cache entries that cannot be written are skipped
+
+    Arguments
+    ---------
+    None
+
+    Return
+    ------
+    std::string cache directory
+  */
+  const char * env = getenv("CYOA_CACHE_DIR");
+  std::string dir = (env != NULL && *env != '\0') ? env : ".cyoa-cache";
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "Cannot create cache directory " << dir << ": " << strerror(errno)
+              << std::endl;
+  }
+  return dir;
+}
+
+std::string getCacheFile(uint64_t hash, const std::string & suffix) {
+  /*
+    Return path to cache entry for uint64_t hash
+
+    Arguments
+    ---------
+    uint64_t hash: story hash
+    const std::string & suffix: file extension for kind of cache entry
+
+    Return
+    ------
+    std::string path to cache entry
+  */
+  std::stringstream ss;
+  ss << getCacheDir() << "/" << std::hex << hash << suffix;
+  return ss.str();
+}
+
+std::string getTempFile(const std::string & file) {
+  /*
+    Return name of temporary file to write before renaming it over std::string & file,
+    unique to this process so concurrent writers do not clobber each other
+
+    Arguments
+    ---------
+    const std::string & file: path to file being replaced
+
+    Return
+    ------
+    std::string path to temporary file
+  */
+  std::stringstream ss;
+  ss << file << "." << getpid() << ".tmp";
+  return ss.str();
+}
+
+bool printCachedPaths(std::string & file, uint64_t hash) {
+  /*
+    Print winnable paths from cache entry std::string & file
+
+    Arguments
+    ---------
+    std::string & file: path to cache entry
+    uint64_t hash: story hash expected in cache entry
+
+    Return
+    ------
+    bool indicating if cache entry was complete and printed (true), and if not (false)
+  */
+  std::ifstream infile(file.c_str());
+  if (!infile.good()) {
+    return false;
+  }
+  std::string header;
+  uint64_t cached = 0;
+  if (!(infile >> header >> std::hex >> cached) || header.compare("cyoa-cache") != 0 ||
+      cached != hash) {
+    return false;
+  }
+  std::string line;
+  getline(infile, line);
+  std::streamoff start = infile.tellg();
+  infile.seekg(0, std::ios::end);
+  std::streamoff end = infile.tellg();
+  std::streamoff tailSize = std::min(end - start, (std::streamoff)CACHE_TAIL);
+  std::string tail(tailSize, '\0');
+  infile.seekg(end - tailSize);
+  infile.read(&tail[0], tailSize);
+  size_t pos = tail.rfind("cyoa-cache-end ");
+  if (!infile.good() || pos == tail.npos || (pos > 0 && tail[pos - 1] != '\n')) {
+    return false;
+  }
+  std::streamoff remaining = end - tailSize + pos - start;
+  std::vector<char> buffer(CACHE_BLOCK);
+  infile.seekg(start);
+  while (remaining > 0 && infile.good()) {
+    std::streamsize count = std::min(remaining, (std::streamoff)buffer.size());
+    infile.read(&buffer[0], count);
+    std::cout.write(&buffer[0], count);
+    remaining -= count;
+  }
+  std::cout.flush();
+  return true;
+}
+
+size_t writeCachedPaths(Story * story, std::string & file, uint64_t hash) {
+  /*
+    Print winnable paths in Story and store them in cache entry std::string & file
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    std::string & file: path to cache entry
+    uint64_t hash: story hash
+
+    Return
+    ------
+    size_t number of winnable paths
+  */
+  std::string tmpfile = getTempFile(file);
+  std::ofstream outfile(tmpfile.c_str());
+  outfile << "cyoa-cache " << std::hex << hash << std::dec << "\n";
+  PathIterator cursor(story);
+  std::vector<size_t> path;
+  while (cursor.next(path, 0) == 1) {
+    printPath(story, path, std::cout);
+    printPath(story, path, outfile);
+  }
+  if (cursor.getEmitted() == 0) {
+    std::cout << "This story is unwinnable!\n";
+    outfile << "This story is unwinnable!\n";
+  }
+  std::cout.flush();
+  outfile << "cyoa-cache-end " << cursor.getEmitted() << "\n";
+  outfile.close();
+  if (!outfile.good() || std::rename(tmpfile.c_str(), file.c_str()) != 0) {
+    std::remove(tmpfile.c_str());
+  }
+  return cursor.getEmitted();
+}
+
+void printAllPathsCached(Story * story) {
+  /*
+    Print all winnable paths in Story for all Win Page(s), reusing cached results
+    for an unchanged story graph
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    None
+  */
+  checkStory(story);
+  uint64_t hash = hashStory(story);
+  std::string file = getCacheFile(hash, ".paths");
+  if (!printCachedPaths(file, hash)) {
+    writeCachedPaths(story, file, hash);
+  }
+}
+
+// VALIDATION CACHE
+uint64_t hashValidation(char * dir, std::vector<std::string> & lines, std::string & mode) {
+  /*
+    Return hash of validator version, story.txt file lines, and size and
+    modification time of each page file it declares, or 0 if the validation cache
+    is off because CYOA_CACHE_DIR is not set
+
+    Arguments
+    ---------
+    char * dir: directory with story.txt file
+    std::vector<std::string> & lines: story file lines
+    std::string & mode: story kind validated, normal (N) or conditional (C)
+
+    Return
+    ------
+    uint64_t validation cache key
+  */
+  const char * env = getenv("CYOA_CACHE_DIR");
+  if (env == NULL || *env == '\0') {
+    return 0;
+  }
+  std::stringstream ss;
+  ss << "v" << VALIDATION_VERSION << " " << mode << "\n";
+  std::vector<std::string>::iterator it = lines.begin();
+  while (it != lines.end()) {
+    ss << *it << "\n";
+    if (it->find("@") != it->npos) {
+      std::string file = getFile(*it);
+      std::string path = buildPath(dir, file);
+      struct stat info;
+      if (stat(path.c_str(), &info) == 0) {
+        ss << info.st_size << " " << info.st_mtime << "\n";
+      }
+    }
+    ++it;
+  }
+  return hashString(ss.str());
+}
+
+bool isValidated(uint64_t key) {
+  /*
+    Indicates if story with validation cache key passed validation on a previous run
+
+    Arguments
+    ---------
+    uint64_t key: validation cache key, or 0 if the validation cache is off
+
+    Return
+    ------
+    bool indicating if cache entry for key exists (true), and if not (false)
+  */
+  if (key == 0) {
+    return false;
+  }
+  std::string file = getCacheFile(key, ".valid");
+  std::ifstream infile(file.c_str());
+  std::string header;
+  uint64_t cached = 0;
+  if (infile >> header >> std::hex >> cached) {
+    return !header.compare("cyoa-valid") && cached == key;
+  }
+  return false;
+}
+
+void saveValidation(uint64_t key) {
+  /*
+    Record that story with validation cache key passed validation
+
+    Arguments
+    ---------
+    uint64_t key: validation cache key, or 0 if story has none
+
+    Return
+    ------
+    None
+  */
+  if (key == 0) {
+    return;
+  }
+  std::string file = getCacheFile(key, ".valid");
+  std::ofstream outfile(file.c_str());
+  outfile << "cyoa-valid " << std::hex << key << "\n";
+}
+
+//======================================================================
+
+StoryGraph::StoryGraph(Story * story) :
+    external(),
+    internal(),
+    types(),
+    first(1, 0),
+    dests(),
+    predFirst(),
+    preds(),
+    invalidRefs() {
+  std::map<size_t, Page *> & pages = story->getPages();
+  size_t numPages = pages.empty() ? 0 : pages.rbegin()->first + 1;
+  std::vector<Page *> byNum(numPages, (Page *)NULL);
+  std::map<size_t, Page *>::iterator it = pages.begin();
+  while (it != pages.end()) {
+    byNum[it->first] = it->second;
+    ++it;
+  }
+  internal.assign(numPages, NO_PAGE);
+  external.reserve(pages.size());
+  // BFS order from page 0, then pages unreachable from page 0 in page order
+  if (numPages > 0 && byNum[0] != NULL) {
+    internal[0] = 0;
+    external.push_back(0);
+  }
+  for (size_t head = 0; head < external.size(); head++) {
+    std::vector<size_t> & destpages = byNum[external[head]]->getDestpages();
+    std::vector<size_t>::iterator destIt = destpages.begin();
+    while (destIt != destpages.end()) {
+      if (*destIt < numPages && internal[*destIt] == NO_PAGE && byNum[*destIt] != NULL) {
+        internal[*destIt] = external.size();
+        external.push_back(*destIt);
+      }
+      ++destIt;
+    }
+  }
+  for (size_t pagenum = 0; pagenum < numPages; pagenum++) {
+    if (internal[pagenum] == NO_PAGE && byNum[pagenum] != NULL) {
+      internal[pagenum] = external.size();
+      external.push_back(pagenum);
+    }
+  }
+  types.reserve(external.size());
+  first.reserve(external.size() + 1);
+  for (size_t node = 0; node < external.size(); node++) {
+    Page * page = byNum[external[node]];
+    types.push_back(page->getPagetype()[0]);
+    std::vector<size_t> & destpages = page->getDestpages();
+    std::vector<size_t>::iterator destIt = destpages.begin();
+    while (destIt != destpages.end()) {
+      dests.push_back(*destIt < numPages ? internal[*destIt] : NO_PAGE);
+      if (dests.back() == NO_PAGE) {
+        invalidRefs.push_back(*destIt);
+      }
+      ++destIt;
+    }
+    first.push_back(dests.size());
+  }
+  predFirst.assign(external.size() + 1, 0);
+  for (size_t edge = 0; edge < dests.size(); edge++) {
+    if (dests[edge] != NO_PAGE) {
+      predFirst[dests[edge] + 1]++;
+    }
+  }
+  for (size_t node = 0; node < external.size(); node++) {
+    predFirst[node + 1] += predFirst[node];
+  }
+  preds.resize(predFirst[external.size()]);
+  std::vector<size_t> fill(predFirst.begin(), predFirst.end() - 1);
+  for (size_t node = 0; node < external.size(); node++) {
+    for (size_t edge = first[node]; edge < first[node + 1]; edge++) {
+      if (dests[edge] != NO_PAGE) {
+        preds[fill[dests[edge]]++] = node;
+      }
+    }
+  }
+}
+
+StoryGraph::~StoryGraph() {
+}
+
+size_t StoryGraph::size() const {
+  return external.size();
+}
+
+size_t StoryGraph::toExternal(size_t node) const {
+  return external[node];
+}
+
+size_t StoryGraph::toInternal(size_t pagenum) const {
+  return pagenum < internal.size() ? internal[pagenum] : NO_PAGE;
+}
+
+char StoryGraph::getType(size_t node) const {
+  return types[node];
+}
+
+size_t StoryGraph::firstEdge(size_t node) const {
+  return first[node];
+}
+
+size_t StoryGraph::lastEdge(size_t node) const {
+  return first[node + 1];
+}
+
+size_t StoryGraph::getDest(size_t edge) const {
+  return dests[edge];
+}
+
+size_t StoryGraph::firstPred(size_t node) const {
+  return predFirst[node];
+}
+
+size_t StoryGraph::lastPred(size_t node) const {
+  return predFirst[node + 1];
+}
+
+size_t StoryGraph::getPred(size_t idx) const {
+  return preds[idx];
+}
+
+const std::vector<size_t> & StoryGraph::getInvalidRefs() const {
+  return invalidRefs;
+}
+
+//======================================================================
+
+PathQuery::PathQuery(const StoryGraph & graph,
+                     std::vector<size_t> & must,
+                     std::vector<size_t> & avoid) :
+    avoided(graph.size(), 0),
+    required(graph.size(), NO_PAGE),
+    numRequired(0),
+    words(0),
+    reach() {
+  std::vector<size_t>::iterator it = avoid.begin();
+  while (it != avoid.end()) {
+    if (graph.toInternal(*it) != NO_PAGE) {
+      avoided[graph.toInternal(*it)] = 1;
+    }
+    ++it;
+  }
+  std::vector<size_t> musts;
+  it = must.begin();
+  while (it != must.end()) {
+    size_t node = graph.toInternal(*it);
+    if (node != NO_PAGE && required[node] == NO_PAGE) {
+      required[node] = numRequired++;
+      musts.push_back(node);
+    }
+    ++it;
+  }
+  words = (numRequired + 63) / 64;
+  reach.assign(graph.size() * words, 0);
+  // reverse BFS from each must-visit page through pages that are not avoided
+  std::vector<size_t> queue;
+  for (size_t idx = 0; idx < numRequired; idx++) {
+    uint64_t bit = (uint64_t)1 << (idx % 64);
+    size_t word = idx / 64;
+    queue.clear();
+    if (!avoided[musts[idx]]) {
+      reach[musts[idx] * words + word] |= bit;
+      queue.push_back(musts[idx]);
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+      size_t node = queue[head];
+      for (size_t i = graph.firstPred(node); i < graph.lastPred(node); i++) {
+        size_t pred = graph.getPred(i);
+        if (!avoided[pred] && !(reach[pred * words + word] & bit)) {
+          reach[pred * words + word] |= bit;
+          queue.push_back(pred);
+        }
+      }
+    }
+  }
+}
+
+PathQuery::~PathQuery() {
+}
+
+bool PathQuery::isEmpty() const {
+  return numRequired == 0 &&
+         std::find(avoided.begin(), avoided.end(), 1) == avoided.end();
+}
+
+bool PathQuery::isAvoided(size_t node) const {
+  return avoided[node];
+}
+
+size_t PathQuery::getRequired(size_t node) const {
+  return required[node];
+}
+
+std::vector<uint64_t> PathQuery::getPending() const {
+  std::vector<uint64_t> pending(words, ~(uint64_t)0);
+  if (numRequired % 64 != 0) {
+    pending.back() = ((uint64_t)1 << (numRequired % 64)) - 1;
+  }
+  return pending;
+}
+
+bool PathQuery::canReach(size_t node, const std::vector<uint64_t> & pending) const {
+  for (size_t word = 0; word < words; word++) {
+    if ((reach[node * words + word] & pending[word]) != pending[word]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//======================================================================
+
+ChainGraph::ChainGraph(Story * story) :
+    graph(story),
+    first(),
+    dests(),
+    viaFirst(1, 0),
+    via() {
+  size_t numNodes = graph.size();
+  first.assign(numNodes + 1, 0);
+  std::vector<char> inChain(numNodes, 0);
+  for (size_t node = 0; node < numNodes; node++) {
+    first[node] = dests.size();
+    size_t degree = graph.lastEdge(node) - graph.firstEdge(node);
+    if (degree == 1 && node != 0) {
+      continue;
+    }
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      size_t start = via.size();
+      bool cycle = false;
+      while (graph.lastEdge(dest) - graph.firstEdge(dest) == 1 && dest != node) {
+        if (inChain[dest]) {
+          cycle = true;
+          break;
+        }
+        inChain[dest] = 1;
+        via.push_back(dest);
+        dest = graph.getDest(graph.firstEdge(dest));
+      }
+      for (size_t i = start; i < via.size(); i++) {
+        inChain[via[i]] = 0;
+      }
+      if (cycle) {
+        via.resize(start);
+      }
+      else {
+        dests.push_back(dest);
+        viaFirst.push_back(via.size());
+      }
+    }
+  }
+  first[numNodes] = dests.size();
+}
+
+ChainGraph::~ChainGraph() {
+}
+
+size_t ChainGraph::numEdges() const {
+  return dests.size();
+}
+
+const StoryGraph & ChainGraph::getGraph() const {
+  return graph;
+}
+
+size_t ChainGraph::printPaths(Story * story,
+                              size_t to,
+                              std::ostream & out,
+                              const PathQuery * query) const {
+  size_t numPaths = 0;
+  size_t target = graph.toInternal(to);
+  std::vector<size_t> path(1, 0);
+  if (graph.size() == 0 || graph.toExternal(0) != 0) {
+    return 0;
+  }
+  bool constrained = query != NULL && !query->isEmpty();
+  std::vector<uint64_t> pending;
+  if (constrained) {
+    pending = query->getPending();
+    if (query->isAvoided(0)) {
+      return 0;
+    }
+    if (query->getRequired(0) != NO_PAGE) {
+      size_t idx = query->getRequired(0);
+      pending[idx / 64] &= ~((uint64_t)1 << (idx % 64));
+    }
+    if (!query->canReach(0, pending)) {
+      return 0;
+    }
+  }
+  if (to == 0) {
+    printPath(story, path, out);
+    return 1;
+  }
+  // frame: node, super-edges left to explore, length of path before node
+  std::vector<char> onPath(graph.size(), 0);
+  std::vector<size_t> nodes(1, 0);
+  std::vector<size_t> remaining(1, first[1] - first[0]);
+  std::vector<size_t> lengths(1, 0);
+  std::vector<size_t> visited(1, 0);
+  onPath[0] = 1;
+  while (!nodes.empty()) {
+    size_t node = nodes.back();
+    if (remaining.back() == 0) {
+      for (size_t i = lengths.back(); i < visited.size(); i++) {
+        onPath[visited[i]] = 0;
+        if (constrained && query->getRequired(visited[i]) != NO_PAGE) {
+          size_t idx = query->getRequired(visited[i]);
+          pending[idx / 64] |= (uint64_t)1 << (idx % 64);
+        }
+      }
+      visited.resize(lengths.back());
+      path.resize(lengths.back());
+      nodes.pop_back();
+      remaining.pop_back();
+      lengths.pop_back();
+      continue;
+    }
+    size_t edge = first[node] + --remaining.back();
+    size_t dest = dests[edge];
+    if (onPath[dest]) {
+      continue;
+    }
+    bool simple = true;
+    for (size_t i = viaFirst[edge]; i < viaFirst[edge + 1]; i++) {
+      if (onPath[via[i]]) {
+        simple = false;
+        break;
+      }
+    }
+    if (!simple) {
+      continue;
+    }
+    if (constrained) {
+      bool avoided = query->isAvoided(dest);
+      for (size_t i = viaFirst[edge]; i < viaFirst[edge + 1] && !avoided; i++) {
+        avoided = query->isAvoided(via[i]);
+      }
+      if (avoided) {
+        continue;
+      }
+    }
+    size_t length = visited.size();
+    for (size_t i = viaFirst[edge]; i < viaFirst[edge + 1]; i++) {
+      onPath[via[i]] = 1;
+      visited.push_back(via[i]);
+      path.push_back(graph.toExternal(via[i]));
+    }
+    onPath[dest] = 1;
+    visited.push_back(dest);
+    path.push_back(graph.toExternal(dest));
+    bool live = true;
+    if (constrained) {
+      for (size_t i = length; i < visited.size(); i++) {
+        if (query->getRequired(visited[i]) != NO_PAGE) {
+          size_t idx = query->getRequired(visited[i]);
+          pending[idx / 64] &= ~((uint64_t)1 << (idx % 64));
+        }
+      }
+      // branches that cannot reach every remaining must-visit page are popped
+      // straight away, which also restores their pending bits
+      live = query->canReach(dest, pending);
+    }
+    if (dest == target && live) {
+      printPath(story, path, out);
+      numPaths++;
+    }
+    nodes.push_back(dest);
+    remaining.push_back(live ? first[dest + 1] - first[dest] : 0);
+    lengths.push_back(length);
+  }
+  return numPaths;
+}
+
+//======================================================================
+
+SubgraphClasses::SubgraphClasses(Story * story) :
+    classOf(),
+    counts(),
+    liveFirst(1, 0),
+    live() {
+  std::map<size_t, Page *> & pages = story->getPages();
+  size_t numPages = pages.empty() ? 0 : pages.rbegin()->first + 1;
+  classOf.assign(numPages, NO_CLASS);
+  if (pages.find(0) == pages.end()) {
+    return;
+  }
+  // post-order DFS from page 0; a page is closed if no cycle is reachable from it
+  std::vector<char> color(numPages, 0);
+  std::vector<char> closed(numPages, 1);
+  std::vector<size_t> order;
+  std::vector<std::pair<size_t, size_t> > todo;
+  todo.push_back(std::make_pair(0, 0));
+  color[0] = 1;
+  while (!todo.empty()) {
+    size_t page = todo.back().first;
+    std::vector<size_t> & destpages = pages[page]->getDestpages();
+    if (todo.back().second < destpages.size()) {
+      size_t dest = destpages[todo.back().second++];
+      if (color[dest] == 0) {
+        color[dest] = 1;
+        todo.push_back(std::make_pair(dest, 0));
+      }
+      else if (color[dest] == 1 || !closed[dest]) {
+        closed[page] = 0;
+      }
+      continue;
+    }
+    color[page] = 2;
+    order.push_back(page);
+    todo.pop_back();
+    if (!todo.empty() && !closed[page]) {
+      closed[todo.back().first] = 0;
+    }
+  }
+  std::map<std::vector<size_t>, size_t> interned;
+  std::vector<size_t>::iterator it = order.begin();
+  while (it != order.end()) {
+    if (!closed[*it]) {
+      ++it;
+      continue;
+    }
+    Page * page = pages[*it];
+    std::vector<size_t> & destpages = page->getDestpages();
+    std::vector<size_t> signature;
+    signature.push_back(page->getPagetype()[0]);
+    for (size_t i = 0; i < destpages.size(); i++) {
+      signature.push_back(classOf[destpages[i]]);
+    }
+    std::map<std::vector<size_t>, size_t>::iterator found = interned.find(signature);
+    if (found != interned.end()) {
+      classOf[*it] = found->second;
+      ++it;
+      continue;
+    }
+    long double count = page->getPagetype().compare("W") ? 0 : 1;
+    for (size_t i = 0; i < destpages.size(); i++) {
+      long double childCount = counts[classOf[destpages[i]]];
+      if (childCount > 0) {
+        count += childCount;
+        live.push_back(i);
+      }
+    }
+    classOf[*it] = counts.size();
+    interned[signature] = counts.size();
+    counts.push_back(count);
+    liveFirst.push_back(live.size());
+    ++it;
+  }
+}
+
+SubgraphClasses::~SubgraphClasses() {
+}
+
+size_t SubgraphClasses::numClasses() const {
+  return counts.size();
+}
+
+size_t SubgraphClasses::getClass(size_t pagenum) const {
+  return classOf[pagenum];
+}
+
+long double SubgraphClasses::countPaths(Story * story) const {
+  if (classOf.empty()) {
+    return 0;
+  }
+  if (classOf[0] != NO_CLASS) {
+    return counts[classOf[0]];
+  }
+  // only pages that can reach a cycle are walked; shared classes add their count
+  long double count = 0;
+  std::vector<char> onPath(classOf.size(), 0);
+  std::vector<std::pair<size_t, size_t> > todo;
+  todo.push_back(std::make_pair(0, 0));
+  onPath[0] = 1;
+  while (!todo.empty()) {
+    size_t page = todo.back().first;
+    std::vector<size_t> & destpages = story->getPage(page)->getDestpages();
+    if (todo.back().second == destpages.size()) {
+      onPath[page] = 0;
+      todo.pop_back();
+      continue;
+    }
+    size_t dest = destpages[todo.back().second++];
+    if (classOf[dest] != NO_CLASS) {
+      count += counts[classOf[dest]];
+    }
+    else if (!onPath[dest]) {
+      onPath[dest] = 1;
+      todo.push_back(std::make_pair(dest, 0));
+    }
+  }
+  return count;
+}
+
+size_t SubgraphClasses::printPaths(Story * story, std::ostream & out) const {
+  size_t numPaths = 0;
+  if (classOf.empty()) {
+    return numPaths;
+  }
+  std::vector<char> onPath(classOf.size(), 0);
+  std::vector<size_t> path;
+  std::vector<size_t> remaining;
+  path.push_back(0);
+  onPath[0] = 1;
+  if (classOf[0] == NO_CLASS) {
+    remaining.push_back(story->getPage(0)->getDestpages().size());
+  }
+  else {
+    remaining.push_back(liveFirst[classOf[0] + 1] - liveFirst[classOf[0]]);
+    if (!story->getPage(0)->getPagetype().compare("W")) {
+      printPath(story, path, out);
+      numPaths++;
+    }
+  }
+  while (!path.empty()) {
+    size_t page = path.back();
+    if (remaining.back() == 0) {
+      onPath[page] = 0;
+      path.pop_back();
+      remaining.pop_back();
+      continue;
+    }
+    size_t idx = --remaining.back();
+    size_t cls = classOf[page];
+    size_t choice = (cls == NO_CLASS) ? idx : live[liveFirst[cls] + idx];
+    size_t dest = story->getPage(page)->getDestpages()[choice];
+    size_t destCls = classOf[dest];
+    if (destCls == NO_CLASS) {
+      if (onPath[dest]) {
+        continue;
+      }
+      remaining.push_back(story->getPage(dest)->getDestpages().size());
+    }
+    else if (counts[destCls] > 0) {
+      remaining.push_back(liveFirst[destCls + 1] - liveFirst[destCls]);
+    }
+    else {
+      continue;
+    }
+    onPath[dest] = 1;
+    path.push_back(dest);
+    if (!story->getPage(dest)->getPagetype().compare("W")) {
+      printPath(story, path, out);
+      numPaths++;
+    }
+  }
+  return numPaths;
+}
+
+//======================================================================
+
+HintTable::HintTable(Story * story) : distances(), choices() {
+  StoryGraph graph(story);
+  size_t numPages = 0;
+  for (size_t node = 0; node < graph.size(); node++) {
+    numPages = std::max(numPages, graph.toExternal(node) + 1);
+  }
+  distances.assign(numPages, NO_HINT);
+  choices.assign(numPages, 0);
+  std::vector<size_t> queue;
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (graph.getType(node) == 'W') {
+      distances[graph.toExternal(node)] = 0;
+      queue.push_back(node);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    size_t node = queue[head];
+    uint32_t distance = distances[graph.toExternal(node)] + 1;
+    for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+      size_t pred = graph.getPred(idx);
+      size_t pagenum = graph.toExternal(pred);
+      if (distances[pagenum] != NO_HINT) {
+        continue;
+      }
+      size_t edge = graph.firstEdge(pred);
+      while (graph.getDest(edge) != node) {
+        edge++;
+      }
+      distances[pagenum] = distance;
+      choices[pagenum] = edge - graph.firstEdge(pred) + 1;
+      queue.push_back(pred);
+    }
+  }
+}
+
+HintTable::~HintTable() {
+}
+
+bool HintTable::hasHint(size_t pagenum) const {
+  return pagenum < distances.size() && distances[pagenum] != NO_HINT;
+}
+
+size_t HintTable::getChoice(size_t pagenum) const {
+  return pagenum < choices.size() ? choices[pagenum] : 0;
+}
+
+size_t HintTable::getDistance(size_t pagenum) const {
+  return hasHint(pagenum) ? distances[pagenum] : NO_PAGE;
+}
+
+// SHARED SUBGRAPHS
+void printSharedPaths(int argc, char ** argv) {
+  /*
+    Print all winnable paths in Story, or their number with the count option, using
+    shared subgraph classes
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: count (optional)
+
+    Return
+    ------
+    None
+  */
+  if ((argc != 2 && argc != 3) || (argc == 3 && strcmp(argv[2], "count") != 0)) {
+    std::cerr << "Usage: ./cyoa-share <dir> [count]\n";
+    exit(EXIT_FAILURE);
+  }
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  SubgraphClasses classes(story);
+  if (argc == 3) {
+    std::cout << std::fixed << std::setprecision(0) << classes.countPaths(story)
+              << " winnable paths, " << classes.numClasses()
+              << " shared subgraph classes" << std::endl;
+  }
+  else if (classes.printPaths(story, std::cout) == 0) {
+    std::cout << "This story is unwinnable!" << std::endl;
+  }
+  std::cout.flush();
+  delete story;
+}
+
+// DOMINATORS
+std::vector<size_t> findDominators(StoryGraph & graph) {
+  /*
+    Return immediate dominator of each page in story graph rooted at page 0
+    (Cooper, Harvey, and Kennedy iterative algorithm over reverse postorder)
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+
+    Return
+    ------
+    std::vector<size_t> immediate dominator (internal node) for each internal node,
+    or NO_PAGE for nodes unreachable from page 0
+  */
+  size_t numNodes = graph.size();
+  std::vector<size_t> idom(numNodes, NO_PAGE);
+  if (numNodes == 0 || graph.toExternal(0) != 0) {
+    return idom;
+  }
+  std::vector<size_t> order;
+  std::vector<size_t> rpoNum(numNodes, NO_PAGE);
+  std::vector<char> visited(numNodes, 0);
+  std::vector<std::pair<size_t, size_t> > todo;
+  todo.push_back(std::make_pair(0, graph.firstEdge(0)));
+  visited[0] = 1;
+  while (!todo.empty()) {
+    size_t node = todo.back().first;
+    if (todo.back().second < graph.lastEdge(node)) {
+      size_t dest = graph.getDest(todo.back().second++);
+      if (!visited[dest]) {
+        visited[dest] = 1;
+        todo.push_back(std::make_pair(dest, graph.firstEdge(dest)));
+      }
+      continue;
+    }
+    order.push_back(node);
+    todo.pop_back();
+  }
+  std::reverse(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); i++) {
+    rpoNum[order[i]] = i;
+  }
+  idom[0] = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 1; i < order.size(); i++) {
+      size_t node = order[i];
+      size_t newIdom = NO_PAGE;
+      for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+        size_t pred = graph.getPred(idx);
+        if (idom[pred] == NO_PAGE) {
+          continue;
+        }
+        if (newIdom == NO_PAGE) {
+          newIdom = pred;
+          continue;
+        }
+        size_t finger1 = pred;
+        size_t finger2 = newIdom;
+        while (finger1 != finger2) {
+          while (rpoNum[finger1] > rpoNum[finger2]) {
+            finger1 = idom[finger1];
+          }
+          while (rpoNum[finger2] > rpoNum[finger1]) {
+            finger2 = idom[finger2];
+          }
+        }
+        newIdom = finger1;
+      }
+      if (idom[node] != newIdom) {
+        idom[node] = newIdom;
+        changed = true;
+      }
+    }
+  }
+  return idom;
+}
+
+void printDominators(Story * story) {
+  /*
+    Print pages every playthrough must visit to reach each Win Page in Story
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    None
+  */
+  checkStory(story);
+  StoryGraph graph(story);
+  std::vector<size_t> idom = findDominators(graph);
+  std::string win("W");
+  std::set<size_t> winpages = story->getPagetypes(win);
+  std::set<size_t>::iterator it = winpages.begin();
+  while (it != winpages.end()) {
+    size_t node = graph.toInternal(*it);
+    std::cout << "Page " << *it << ":";
+    if (idom[node] == NO_PAGE) {
+      std::cout << " unreachable\n";
+      ++it;
+      continue;
+    }
+    std::vector<size_t> chain;
+    chain.push_back(node);
+    while (node != 0) {
+      node = idom[node];
+      chain.push_back(node);
+    }
+    std::string delim(" ");
+    std::vector<size_t>::reverse_iterator chainIt = chain.rbegin();
+    while (chainIt != chain.rend()) {
+      std::cout << delim << graph.toExternal(*chainIt);
+      delim = ",";
+      ++chainIt;
+    }
+    std::cout << "\n";
+    ++it;
+  }
+  std::cout.flush();
+}
+
+// MARKOV CHAIN
+std::map<std::pair<size_t, size_t>, double> readChoiceStats(char * file) {
+  /*
+    Read choice statistics file with one <page>:<choice>:<weight> line per choice
+
+    Arguments
+    ---------
+    char * file: path to choice statistics file
+
+    Return
+    ------
+    std::map<std::pair<size_t, size_t>, double> weight for each (page number,
+    choice number)
+  */
+  std::string path(file);
+  std::ifstream infile(path.c_str());
+  checkInfile(infile, path);
+  std::map<std::pair<size_t, size_t>, double> stats;
+  std::string line;
+  while (getline(infile, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    size_t pagenum = 0;
+    size_t choice = 0;
+    double weight = 0;
+    char colon1 = 0;
+    char colon2 = 0;
+    std::stringstream ss(line);
+    if (!(ss >> pagenum >> colon1 >> choice >> colon2 >> weight) || colon1 != ':' ||
+        colon2 != ':' || choice == 0 || weight < 0) {
+      std::cerr << "Invalid Choice Statistic: " << line << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    stats[std::make_pair(pagenum, choice)] = weight;
+  }
+  return stats;
+}
+
+std::vector<double> buildTransitions(StoryGraph & graph,
+                                     std::map<std::pair<size_t, size_t>, double> & stats) {
+  /*
+    Return probability of each choice in story graph, proportional to the weights of
+    its page's choice statistics, with missing choices weighing 0; pages without any
+    statistics lines are uniform over their choices. Exit if a statistic names a page
+    or choice that is not in the story, or if a page's statistics all weigh 0
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::map<std::pair<size_t, size_t>, double> & stats: weight for each (page
+    number, choice number)
+
+    Return
+    ------
+    std::vector<double> probability of each choice index in graph
+  */
+  std::map<std::pair<size_t, size_t>, double>::iterator statIt = stats.begin();
+  while (statIt != stats.end()) {
+    size_t node = graph.toInternal(statIt->first.first);
+    if (node == NO_PAGE ||
+        statIt->first.second > graph.lastEdge(node) - graph.firstEdge(node)) {
+      std::cerr << "Invalid Choice Statistic: " << statIt->first.first << ":"
+                << statIt->first.second << " is not a choice in the story" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    ++statIt;
+  }
+  std::vector<double> probs;
+  for (size_t node = 0; node < graph.size(); node++) {
+    size_t pagenum = graph.toExternal(node);
+    size_t degree = graph.lastEdge(node) - graph.firstEdge(node);
+    std::vector<double> weights(degree, 0);
+    double total = 0;
+    bool given = false;
+    for (size_t i = 0; i < degree; i++) {
+      std::map<std::pair<size_t, size_t>, double>::iterator it =
+          stats.find(std::make_pair(pagenum, i + 1));
+      if (it != stats.end()) {
+        weights[i] = it->second;
+        total += it->second;
+        given = true;
+      }
+    }
+    if (given && total == 0) {
+      std::cerr << "Invalid Choice Statistic: every choice on page " << pagenum
+                << " has weight 0" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < degree; i++) {
+      probs.push_back(total > 0 ? weights[i] / total : 1.0 / degree);
+    }
+  }
+  return probs;
+}
+
+void checkAbsorbing(StoryGraph & graph, std::vector<double> & probs) {
+  /*
+    Exit if any page cannot reach a Win or Lose page through choices with non-zero
+    probability, since the Markov chain is then not absorbing and has no solution
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<double> & probs: probability of each choice index in graph
+
+    Return
+    ------
+    None
+  */
+  std::vector<char> canEnd(graph.size(), 0);
+  std::vector<size_t> queue;
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (graph.getType(node) != 'N') {
+      canEnd[node] = 1;
+      queue.push_back(node);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    size_t node = queue[head];
+    for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+      size_t pred = graph.getPred(idx);
+      if (canEnd[pred]) {
+        continue;
+      }
+      for (size_t edge = graph.firstEdge(pred); edge < graph.lastEdge(pred); edge++) {
+        if (graph.getDest(edge) == node && probs[edge] > 0) {
+          canEnd[pred] = 1;
+          queue.push_back(pred);
+          break;
+        }
+      }
+    }
+  }
+  std::vector<size_t> stuck;
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (!canEnd[node]) {
+      stuck.push_back(graph.toExternal(node));
+    }
+  }
+  if (!stuck.empty()) {
+    std::sort(stuck.begin(), stuck.end());
+    std::cerr << "Pages that cannot reach a Win or Lose page under the choice weights:";
+    for (size_t i = 0; i < stuck.size(); i++) {
+      std::cerr << " " << stuck[i];
+    }
+    std::cerr << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+size_t solveMarkovChain(StoryGraph & graph,
+                        std::vector<double> & probs,
+                        std::vector<double> & winProb,
+                        std::vector<double> & expected) {
+  /*
+    Solve absorbing Markov chain over story graph by Gauss-Seidel iteration for the
+    probability of reaching a Win page and the expected number of choices made from
+    each page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<double> & probs: probability of each choice index in graph
+    std::vector<double> & winProb: filled with win probability of each internal node
+    std::vector<double> & expected: filled with expected number of choices from each
+    internal node
+
+    Return
+    ------
+    size_t number of iterations until convergence
+  */
+  size_t numNodes = graph.size();
+  winProb.assign(numNodes, 0);
+  expected.assign(numNodes, 0);
+  for (size_t node = 0; node < numNodes; node++) {
+    if (graph.getType(node) == 'W') {
+      winProb[node] = 1;
+    }
+  }
+  size_t iter = 0;
+  double delta = 1;
+  while (delta > MARKOV_TOLERANCE && iter < MARKOV_MAX_ITER) {
+    delta = 0;
+    // reverse BFS order lets values flow back towards page 0 within one sweep
+    for (size_t node = numNodes; node-- > 0;) {
+      if (graph.getType(node) != 'N') {
+        continue;
+      }
+      double win = 0;
+      double steps = 1;
+      for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+        size_t dest = graph.getDest(edge);
+        win += probs[edge] * winProb[dest];
+        steps += probs[edge] * expected[dest];
+      }
+      delta = std::max(delta, std::fabs(win - winProb[node]));
+      delta = std::max(delta, std::fabs(steps - expected[node]) / steps);
+      winProb[node] = win;
+      expected[node] = steps;
+    }
+    iter++;
+  }
+  return iter;
+}
+
+void printMarkovChain(int argc, char ** argv) {
+  /*
+    Print win probability and expected number of choices under random play from
+    page 0 and from every page in Story
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: choice statistics file (optional)
+
+    Return
+    ------
+    None
+  */
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: ./cyoa-markov <dir> [stats]\n";
+    exit(EXIT_FAILURE);
+  }
+  std::map<std::pair<size_t, size_t>, double> stats;
+  if (argc == 3) {
+    stats = readChoiceStats(argv[2]);
+  }
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  StoryGraph graph(story);
+  std::vector<double> probs = buildTransitions(graph, stats);
+  checkAbsorbing(graph, probs);
+  std::vector<double> winProb;
+  std::vector<double> expected;
+  size_t iter = solveMarkovChain(graph, probs, winProb, expected);
+  if (iter == MARKOV_MAX_ITER) {
+    std::cerr << "Markov chain did not converge after " << iter << " iterations"
+              << std::endl;
+  }
+  std::vector<size_t> order(graph.size());
+  for (size_t node = 0; node < graph.size(); node++) {
+    order[node] = graph.toExternal(node);
+  }
+  std::sort(order.begin(), order.end());
+  std::cout << std::setprecision(6);
+  std::vector<size_t>::iterator it = order.begin();
+  while (it != order.end()) {
+    size_t node = graph.toInternal(*it);
+    std::cout << "Page " << *it << ": win probability " << winProb[node]
+              << ", expected choices " << expected[node] << "\n";
+    ++it;
+  }
+  std::cout.flush();
+  delete story;
+}
+
+// SIMULATION
+uint64_t seedRandom(uint64_t seed) {
+  /*
+    Return well-mixed random generator state for uint64_t seed (splitmix64)
+
+    Arguments
+    ---------
+    uint64_t seed: seed value
+
+    Return
+    ------
+    uint64_t random generator state, never zero
+  */
+  uint64_t z = seed + 0x9e3779b97f4a7c15UL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+  z = z ^ (z >> 31);
+  return z == 0 ? 1 : z;
+}
+
+uint64_t nextRandom(uint64_t & state) {
+  /*
+    Advance random generator state and return next random value (xorshift64*)
+
+    Arguments
+    ---------
+    uint64_t & state: random generator state
+
+    Return
+    ------
+    uint64_t random value
+  */
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545f4914f6cdd1dUL;
+}
+
+size_t randomIndex(uint64_t & state, size_t bound) {
+  /*
+    Return random index less than size_t bound
+
+    Arguments
+    ---------
+    uint64_t & state: random generator state
+    size_t bound: number of indices
+
+    Return
+    ------
+    size_t random index in [0, bound)
+  */
+  return (size_t)(nextRandom(state) % bound);
+}
+
+size_t parseCount(char * arg) {
+  /*
+    Return non-negative number in command line argument char * arg
+
+    Arguments
+    ---------
+    char * arg: command line argument
+
+    Return
+    ------
+    size_t number in arg
+  */
+  char * end = NULL;
+  errno = 0;
+  unsigned long num = std::strtoul(arg, &end, 10);
+  if (errno == ERANGE || end == arg || *end != '\0' || arg[0] == '-') {
+    std::cerr << "Invalid Number: " << arg << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return num;
+}
+
+std::vector<Page *> indexPages(Story * story) {
+  /*
+    Return Page(s) of Story indexed by page number for lookups without std::map
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    std::vector<Page *> Page for each page number, or NULL for missing pages
+  */
+  std::map<size_t, Page *> & pages = story->getPages();
+  size_t numPages = pages.empty() ? 0 : pages.rbegin()->first + 1;
+  std::vector<Page *> byNum(numPages, (Page *)NULL);
+  std::map<size_t, Page *>::iterator it = pages.begin();
+  while (it != pages.end()) {
+    byNum[it->first] = it->second;
+    ++it;
+  }
+  return byNum;
+}
+
+void * runSimShard(void * arg) {
+  /*
+    Run random playthroughs for one simulation shard, following the same memory and
+    choice availability rules as playCondStory; each playthrough draws from its own
+    generator seeded by its run number, so totals do not depend on the shard split
+
+    Arguments
+    ---------
+    void * arg: pointer to SimShard with story, range of runs, seed, and counters
+
+    Return
+    ------
+    NULL
+  */
+  SimShard * shard = (SimShard *)arg;
+  std::vector<Page *> & pages = *shard->pages;
+  uint64_t base = seedRandom(shard->seed);
+  // counters stay local until the end so shards do not share cache lines
+  size_t wins = 0;
+  size_t losses = 0;
+  size_t stuck = 0;
+  size_t unfinished = 0;
+  std::vector<size_t> lengths;
+  std::vector<size_t> visits(pages.size(), 0);
+  std::vector<size_t> valid;
+  const std::vector<long int> & initial = shard->story->getMemory();
+  std::vector<long int> memory;
+  for (size_t run = shard->begin; run < shard->end; run++) {
+    uint64_t state = seedRandom(base + run);
+    memory.assign(initial.begin(), initial.end());
+    size_t pagenum = 0;
+    size_t steps = 0;
+    while (true) {
+      Page * page = pages[pagenum];
+      shard->story->updateMemory(pagenum, memory);
+      visits[pagenum]++;
+      if (page->getPagetype().compare("N") != 0) {
+        if (!page->getPagetype().compare("W")) {
+          wins++;
+        }
+        else {
+          losses++;
+        }
+        if (lengths.size() <= steps) {
+          lengths.resize(steps + 1, 0);
+        }
+        lengths[steps]++;
+        break;
+      }
+      if (steps == SIM_MAX_STEPS) {
+        unfinished++;
+        break;
+      }
+      // conditions are sorted by choice, so one pass pairs them with their choices
+      const std::vector<ChoiceCond> & conds = page->getConditions();
+      std::vector<ChoiceCond>::const_iterator condIt = conds.begin();
+      valid.clear();
+      for (size_t choice = 1; choice <= page->getDestpages().size(); choice++) {
+        if (condIt != conds.end() && condIt->choice == choice) {
+          bool available = page->doesMatchExist(memory, *condIt);
+          ++condIt;
+          if (!available) {
+            continue;
+          }
+        }
+        valid.push_back(choice);
+      }
+      if (valid.empty()) {
+        stuck++;
+        break;
+      }
+      size_t choice = valid[randomIndex(state, valid.size())];
+      pagenum = page->getDestpages()[choice - 1];
+      steps++;
+    }
+  }
+  shard->wins = wins;
+  shard->losses = losses;
+  shard->stuck = stuck;
+  shard->unfinished = unfinished;
+  shard->lengths.swap(lengths);
+  shard->visits.swap(visits);
+  return NULL;
+}
+
+void simulateStory(int argc, char ** argv) {
+  /*
+    Run random playthroughs of conditional Story across threads and print win/lose
+    rates, playthrough length distribution, and page visit frequencies
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: number of playthroughs (optional, default SIM_DEFAULT_RUNS)
+      - argv[3]: random seed (optional, default 1)
+      - argv[4]: number of threads (optional, default number of processors)
+
+    Return
+    ------
+    None
+  */
+  if (argc < 2 || argc > 5) {
+    std::cerr << "Usage: ./cyoa-sim <dir> [runs] [seed] [threads]\n";
+    exit(EXIT_FAILURE);
+  }
+  size_t runs = argc > 2 ? parseCount(argv[2]) : SIM_DEFAULT_RUNS;
+  size_t seed = argc > 3 ? parseCount(argv[3]) : 1;
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t numThreads = argc > 4 ? parseCount(argv[4]) : (cpus > 0 ? cpus : 1);
+  numThreads = std::max((size_t)1, std::min(numThreads, std::max(runs, (size_t)1)));
+  Story * story = buildCondStory(argv[1]);
+  checkStory(story);
+  std::vector<Page *> pages = indexPages(story);
+  std::vector<SimShard> shards(numThreads);
+  std::vector<pthread_t> threads(numThreads);
+  for (size_t i = 0; i < numThreads; i++) {
+    shards[i].story = story;
+    shards[i].pages = &pages;
+    shards[i].begin = i * (runs / numThreads) + std::min(i, runs % numThreads);
+    shards[i].end = shards[i].begin + runs / numThreads + (i < runs % numThreads ? 1 : 0);
+    shards[i].seed = seed;
+    if (pthread_create(&threads[i], NULL, runSimShard, &shards[i]) != 0) {
+      std::cerr << "Failed to start simulation thread" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  SimShard total;
+  total.wins = 0;
+  total.losses = 0;
+  total.stuck = 0;
+  total.unfinished = 0;
+  total.visits.assign(pages.size(), 0);
+  for (size_t i = 0; i < numThreads; i++) {
+    pthread_join(threads[i], NULL);
+    total.wins += shards[i].wins;
+    total.losses += shards[i].losses;
+    total.stuck += shards[i].stuck;
+    total.unfinished += shards[i].unfinished;
+    if (total.lengths.size() < shards[i].lengths.size()) {
+      total.lengths.resize(shards[i].lengths.size(), 0);
+    }
+    for (size_t len = 0; len < shards[i].lengths.size(); len++) {
+      total.lengths[len] += shards[i].lengths[len];
+    }
+    for (size_t page = 0; page < pages.size(); page++) {
+      total.visits[page] += shards[i].visits[page];
+    }
+  }
+  double denom = runs > 0 ? (double)runs : 1;
+  std::cout << "Playthroughs: " << runs << "\n";
+  std::cout << "Win: " << total.wins << " (" << total.wins / denom << ")\n";
+  std::cout << "Lose: " << total.losses << " (" << total.losses / denom << ")\n";
+  std::cout << "No available choice: " << total.stuck << " (" << total.stuck / denom
+            << ")\n";
+  std::cout << "Over " << SIM_MAX_STEPS << " choices: " << total.unfinished << " ("
+            << total.unfinished / denom << ")\n";
+  std::cout << "Choices per finished playthrough:\n";
+  for (size_t len = 0; len < total.lengths.size(); len++) {
+    if (total.lengths[len] > 0) {
+      std::cout << "  " << len << ": " << total.lengths[len] << "\n";
+    }
+  }
+  std::cout << "Visits per playthrough:\n";
+  for (size_t page = 0; page < pages.size(); page++) {
+    if (pages[page] != NULL) {
+      std::cout << "  Page " << page << ": " << total.visits[page] / denom << "\n";
+    }
+  }
+  std::cout.flush();
+  delete story;
+}
+
+// REPLAY
+std::vector<Replay> readReplays(char * file) {
+  /*
+    Read replay file with one recorded playthrough per line
+      - <input> ... [=> <end page> [<variable>=<value> ...]]
+      - inputs are read exactly as cyoa-step4 reads stdin
+      - blank lines and lines starting with # are ignored
+
+    Arguments
+    ---------
+    char * file: path to replay file
+
+    Return
+    ------
+    std::vector<Replay> recorded playthroughs with expected end page and memory
+  */
+  std::string path(file);
+  std::ifstream infile(path.c_str());
+  checkInfile(infile, path);
+  std::vector<Replay> replays;
+  std::string line;
+  size_t linenum = 0;
+  while (getline(infile, line)) {
+    linenum++;
+    std::stringstream ss(line);
+    std::string token;
+    if (!(ss >> token) || token[0] == '#') {
+      continue;
+    }
+    Replay replay;
+    replay.line = linenum;
+    replay.endPage = NO_PAGE;
+    replay.passed = false;
+    do {
+      if (!token.compare("=>")) {
+        break;
+      }
+      replay.inputs.push_back(token);
+    } while (ss >> token);
+    if (!token.compare("=>")) {
+      char * end = NULL;
+      errno = 0;
+      if (!(ss >> token) || token[0] == '-' ||
+          (replay.endPage = std::strtoul(token.c_str(), &end, 10), *end != '\0') ||
+          errno == ERANGE) {
+        std::cerr << "Invalid Replay: line " << linenum << ": " << line << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      while (ss >> token) {
+        size_t pos = token.find("=");
+        errno = 0;
+        long int val = 0;
+        if (pos != std::string::npos && pos > 0) {
+          val = std::strtol(token.c_str() + pos + 1, &end, 10);
+        }
+        if (pos == std::string::npos || pos == 0 || pos + 1 == token.size() ||
+            *end != '\0' || errno == ERANGE) {
+          std::cerr << "Invalid Replay: line " << linenum << ": " << line << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        replay.memory[token.substr(0, pos)] = val;
+      }
+    }
+    replays.push_back(replay);
+  }
+  return replays;
+}
+
+void runReplay(Story * story, std::vector<Page *> & pages, Replay & replay, bool render) {
+  /*
+    Run recorded playthrough through Story following playCondStory, skipping
+    inputs that are not valid or available choices, and record whether it reached
+    the expected end page and memory
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    std::vector<Page *> & pages: Page for each page number
+    Replay & replay: recorded playthrough
+    bool render: whether to record the text cyoa-step4 would print
+
+    Return
+    ------
+    None
+  */
+  std::stringstream out;
+  std::vector<long int> memory = story->getMemory();
+  size_t pagenum = 0;
+  if (render) {
+    out << pages[0]->toString();
+  }
+  std::vector<std::string>::iterator it = replay.inputs.begin();
+  while (pages[pagenum]->getPagetype().compare("N") == 0 && it != replay.inputs.end()) {
+    Page * page = pages[pagenum];
+    story->updateMemory(pagenum, memory);
+    std::set<size_t> invalid = page->getInvalidChoices(memory);
+    size_t max = page->getChoices().size();
+    size_t choice = 0;
+    while (it != replay.inputs.end()) {
+      char * end = NULL;
+      errno = 0;
+      choice = std::strtoul(it->c_str(), &end, 10);
+      ++it;
+      if (errno == ERANGE || choice < 1 || max < choice) {
+        if (render) {
+          out << "That is not a valid choice, please try again" << std::endl;
+        }
+      }
+      else if (invalid.find(choice) != invalid.end()) {
+        if (render) {
+          out << "That choice is not available at this time, please try again"
+              << std::endl;
+        }
+      }
+      else {
+        break;
+      }
+      choice = 0;
+    }
+    if (choice == 0) {
+      break;
+    }
+    pagenum = page->getDestpages()[choice - 1];
+    story->updateMemory(pagenum, memory);
+    if (render) {
+      out << pages[pagenum]->toStringCond(memory);
+    }
+  }
+  std::stringstream result;
+  if (pages[pagenum]->getPagetype().compare("N") == 0) {
+    result << "ran out of input on page " << pagenum;
+  }
+  else if (replay.endPage != NO_PAGE && replay.endPage != pagenum) {
+    result << "expected end page " << replay.endPage << ", reached page " << pagenum;
+  }
+  else {
+    std::map<std::string, long int>::iterator memIt = replay.memory.begin();
+    while (memIt != replay.memory.end()) {
+      size_t var = story->getVarId(memIt->first);
+      if (var == NO_VAR || memory[var] != memIt->second) {
+        result << "expected " << memIt->first << "=" << memIt->second << ", found ";
+        if (var == NO_VAR) {
+          result << "undeclared variable";
+        }
+        else {
+          result << memIt->first << "=" << memory[var];
+        }
+        break;
+      }
+      ++memIt;
+    }
+  }
+  replay.passed = result.str().empty();
+  replay.result = result.str();
+  replay.output = out.str();
+}
+
+void * runReplayShard(void * arg) {
+  /*
+    Run every numShards-th recorded playthrough starting at shard index
+
+    Arguments
+    ---------
+    void * arg: pointer to ReplayShard with story, playthroughs, and shard index
+
+    Return
+    ------
+    NULL
+  */
+  ReplayShard * shard = (ReplayShard *)arg;
+  std::vector<Replay> & replays = *shard->replays;
+  for (size_t i = shard->index; i < replays.size(); i += shard->numShards) {
+    runReplay(shard->story, *shard->pages, replays[i], shard->render);
+  }
+  return NULL;
+}
+
+bool replayStory(int argc, char ** argv) {
+  /*
+    Load Story once and run every recorded playthrough in replay file, across
+    threads, printing each failed playthrough and a summary
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - -j <threads>: number of threads (optional, default 1)
+      - -r: print the text cyoa-step4 would print for each playthrough (optional)
+      - <dir>: directory with story.txt file
+      - <file>: replay file
+
+    Return
+    ------
+    bool true if every playthrough passed
+  */
+  size_t numThreads = 1;
+  bool render = false;
+  int arg = 1;
+  while (arg < argc && argv[arg][0] == '-') {
+    if (!strcmp(argv[arg], "-r")) {
+      render = true;
+    }
+    else if (!strcmp(argv[arg], "-j") && arg + 1 < argc) {
+      numThreads = std::max((size_t)1, parseCount(argv[++arg]));
+    }
+    else {
+      break;
+    }
+    arg++;
+  }
+  if (argc - arg != 2) {
+    std::cerr << "Usage: ./cyoa-replay [-r] [-j threads] <dir> <replay file>\n";
+    exit(EXIT_FAILURE);
+  }
+  Story * story = buildCondStory(argv[arg]);
+  checkStory(story);
+  std::vector<Replay> replays = readReplays(argv[arg + 1]);
+  std::vector<Page *> pages = indexPages(story);
+  numThreads = std::max((size_t)1, std::min(numThreads, replays.size()));
+  std::vector<ReplayShard> shards(numThreads);
+  std::vector<pthread_t> threads(numThreads);
+  for (size_t i = 0; i < numThreads; i++) {
+    shards[i].story = story;
+    shards[i].pages = &pages;
+    shards[i].replays = &replays;
+    shards[i].index = i;
+    shards[i].numShards = numThreads;
+    shards[i].render = render;
+    if (pthread_create(&threads[i], NULL, runReplayShard, &shards[i]) != 0) {
+      std::cerr << "Failed to start replay thread" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (size_t i = 0; i < numThreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  size_t passed = 0;
+  std::vector<Replay>::iterator it = replays.begin();
+  while (it != replays.end()) {
+    std::cout << it->output;
+    if (it->passed) {
+      passed++;
+    }
+    else {
+      std::cout << "Replay line " << it->line << ": " << it->result << "\n";
+    }
+    ++it;
+  }
+  std::cout << "Passed " << passed << " of " << replays.size() << " replays\n";
+  std::cout.flush();
+  delete story;
+  return passed == replays.size();
+}
+
+// EDGE COVER
+std::vector<size_t> findEndEdges(StoryGraph & graph) {
+  /*
+    Return first choice on a shortest route to any end page for each node, found
+    by reverse BFS from every win and lose page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+
+    Return
+    ------
+    std::vector<size_t> edge towards nearest end page for each node, or NO_PAGE for
+    end pages and nodes that cannot reach one
+  */
+  std::vector<size_t> endEdge(graph.size(), NO_PAGE);
+  std::vector<char> seen(graph.size(), 0);
+  std::vector<size_t> queue;
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (graph.getType(node) != 'N') {
+      seen[node] = 1;
+      queue.push_back(node);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    size_t node = queue[head];
+    for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+      size_t pred = graph.getPred(idx);
+      if (seen[pred]) {
+        continue;
+      }
+      size_t edge = graph.firstEdge(pred);
+      while (graph.getDest(edge) != node) {
+        edge++;
+      }
+      seen[pred] = 1;
+      endEdge[pred] = edge;
+      queue.push_back(pred);
+    }
+  }
+  return endEdge;
+}
+
+size_t findUncovered(StoryGraph & graph, std::vector<size_t> & uncovered, size_t from,
+                     std::vector<size_t> & seen, size_t stamp,
+                     std::vector<size_t> & route) {
+  /*
+    Return nearest node from size_t from with an uncovered choice, searching at most
+    COVER_SEARCH_LIMIT nodes by BFS over story graph
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<size_t> & uncovered: number of uncovered choices of each node
+    size_t from: node to search from
+    std::vector<size_t> & seen: stamp of last search that reached each node
+    size_t stamp: stamp of this search, distinct from all earlier ones
+    std::vector<size_t> & route: filled with edges from size_t from to target
+
+    Return
+    ------
+    size_t target node, or NO_PAGE if none was found within the limit
+  */
+  std::vector<size_t> queue(1, from);
+  std::vector<size_t> parent(1, NO_PAGE);
+  std::vector<size_t> parentEdge(1, NO_PAGE);
+  seen[from] = stamp;
+  for (size_t head = 0; head < queue.size() && head < COVER_SEARCH_LIMIT; head++) {
+    size_t node = queue[head];
+    if (uncovered[node] > 0) {
+      route.clear();
+      for (size_t idx = head; parent[idx] != NO_PAGE; idx = parent[idx]) {
+        route.push_back(parentEdge[idx]);
+      }
+      std::reverse(route.begin(), route.end());
+      return node;
+    }
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (dest != NO_PAGE && seen[dest] != stamp) {
+        seen[dest] = stamp;
+        queue.push_back(dest);
+        parent.push_back(head);
+        parentEdge.push_back(edge);
+      }
+    }
+  }
+  return NO_PAGE;
+}
+
+std::vector<std::vector<size_t> > findEdgeCover(StoryGraph & graph) {
+  /*
+    Return playthroughs from page 0 to end pages that together take every choice in
+    story graph at least once, built greedily: walk the BFS tree from page 0 to the
+    first page with an uncovered choice, then keep taking uncovered choices, walking
+    to a nearby page with one whenever the current page has none, and finishing
+    along the shortest route to an end page once none is nearby
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+
+    Return
+    ------
+    std::vector<std::vector<size_t> > edge sequence of each playthrough
+  */
+  std::vector<std::vector<size_t> > playthroughs;
+  if (graph.size() == 0) {
+    return playthroughs;
+  }
+  // nodes are numbered in BFS order from page 0, so the first edge into each node
+  // from a lower node is a BFS tree edge
+  std::vector<size_t> parent(graph.size(), NO_PAGE);
+  std::vector<size_t> parentEdge(graph.size(), NO_PAGE);
+  std::vector<char> covered(graph.lastEdge(graph.size() - 1), 0);
+  std::vector<size_t> uncovered(graph.size(), 0);
+  std::vector<size_t> nextEdge(graph.size(), 0);
+  for (size_t node = 0; node < graph.size(); node++) {
+    nextEdge[node] = graph.firstEdge(node);
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (dest == NO_PAGE) {
+        covered[edge] = 1;
+        continue;
+      }
+      uncovered[node]++;
+      if (dest > node && parent[dest] == NO_PAGE) {
+        parent[dest] = node;
+        parentEdge[dest] = edge;
+      }
+    }
+  }
+  std::vector<size_t> endEdge = findEndEdges(graph);
+  std::vector<size_t> seen(graph.size(), 0);
+  size_t stamp = 0;
+  std::vector<size_t> route;
+  size_t start = 0;
+  while (true) {
+    while (start < graph.size() && uncovered[start] == 0) {
+      start++;
+    }
+    if (start == graph.size() || (start > 0 && parent[start] == NO_PAGE)) {
+      break;
+    }
+    std::vector<size_t> edges;
+    for (size_t node = start; node != 0; node = parent[node]) {
+      edges.push_back(parentEdge[node]);
+    }
+    std::reverse(edges.begin(), edges.end());
+    size_t node = 0;
+    std::vector<size_t>::iterator it = edges.begin();
+    while (it != edges.end()) {
+      if (!covered[*it]) {
+        covered[*it] = 1;
+        uncovered[node]--;
+      }
+      node = graph.getDest(*it);
+      ++it;
+    }
+    while (graph.getType(node) == 'N') {
+      size_t edge = endEdge[node];
+      if (uncovered[node] == 0 &&
+          findUncovered(graph, uncovered, node, seen, ++stamp, route) != NO_PAGE) {
+        edges.insert(edges.end(), route.begin(), route.end());
+        it = route.begin();
+        while (it != route.end()) {
+          if (!covered[*it]) {
+            covered[*it] = 1;
+            uncovered[node]--;
+          }
+          node = graph.getDest(*it);
+          ++it;
+        }
+      }
+      if (uncovered[node] > 0) {
+        while (covered[nextEdge[node]]) {
+          nextEdge[node]++;
+        }
+        edge = nextEdge[node];
+      }
+      if (edge == NO_PAGE) {
+        break;
+      }
+      if (!covered[edge]) {
+        covered[edge] = 1;
+        uncovered[node]--;
+      }
+      edges.push_back(edge);
+      node = graph.getDest(edge);
+    }
+    playthroughs.push_back(edges);
+  }
+  return playthroughs;
+}
+
+void printPlaythrough(StoryGraph & graph, std::vector<size_t> & edges, std::ostream & out) {
+  /*
+    Print playthrough from page 0 with choice number taken on each page and outcome
+    of end page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<size_t> & edges: edge sequence of playthrough
+    std::ostream & out: stream to print playthrough to
+
+    Return
+    ------
+    None
+  */
+  size_t node = 0;
+  std::vector<size_t>::iterator it = edges.begin();
+  while (it != edges.end()) {
+    out << graph.toExternal(node) << "(" << *it - graph.firstEdge(node) + 1 << "),";
+    node = graph.getDest(*it);
+    ++it;
+  }
+  out << graph.toExternal(node);
+  if (graph.getType(node) == 'W') {
+    out << "(win)\n";
+  }
+  else if (graph.getType(node) == 'L') {
+    out << "(lose)\n";
+  }
+  else {
+    out << "\n";
+  }
+}
+
+void printEdgeCover(Story * story) {
+  /*
+    Print set of playthroughs covering every choice in Story
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    None
+  */
+  checkStory(story);
+  StoryGraph graph(story);
+  std::vector<std::vector<size_t> > playthroughs = findEdgeCover(graph);
+  std::vector<std::vector<size_t> >::iterator it = playthroughs.begin();
+  while (it != playthroughs.end()) {
+    printPlaythrough(graph, *it, std::cout);
+    ++it;
+  }
+  std::cout.flush();
+}
+
+// PATH SAMPLING
+bool findTopoOrder(StoryGraph & graph, std::vector<size_t> & order) {
+  /*
+    Find topological order of story graph nodes with Kahn's algorithm
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<size_t> & order: filled with nodes in topological order
+
+    Return
+    ------
+    bool true if story graph is acyclic
+  */
+  std::vector<size_t> indegree(graph.size(), 0);
+  for (size_t node = 0; node < graph.size(); node++) {
+    indegree[node] = graph.lastPred(node) - graph.firstPred(node);
+  }
+  order.clear();
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (indegree[node] == 0) {
+      order.push_back(node);
+    }
+  }
+  for (size_t head = 0; head < order.size(); head++) {
+    size_t node = order[head];
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (dest != NO_PAGE && --indegree[dest] == 0) {
+        order.push_back(dest);
+      }
+    }
+  }
+  return order.size() == graph.size();
+}
+
+std::vector<long double> countWalks(StoryGraph & graph, size_t rows) {
+  /*
+    Return number of walks from each node to a win page, per remaining budget of
+    choices, or a single row of path counts if rows is 1 and story graph is acyclic
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    size_t rows: number of budgets counted (0 to rows - 1 choices)
+
+    Return
+    ------
+    std::vector<long double> count for budget b and node at b * size + node
+  */
+  size_t size = graph.size();
+  std::vector<long double> counts(rows * size, 0);
+  std::vector<size_t> order;
+  if (rows == 1 && findTopoOrder(graph, order)) {
+    std::vector<size_t>::reverse_iterator it = order.rbegin();
+    while (it != order.rend()) {
+      long double count = graph.getType(*it) == 'W' ? 1 : 0;
+      for (size_t edge = graph.firstEdge(*it); edge < graph.lastEdge(*it); edge++) {
+        if (graph.getDest(edge) != NO_PAGE) {
+          count += counts[graph.getDest(edge)];
+        }
+      }
+      counts[*it] = count;
+      ++it;
+    }
+    return counts;
+  }
+  for (size_t budget = 0; budget < rows; budget++) {
+    for (size_t node = 0; node < size; node++) {
+      long double count = graph.getType(node) == 'W' ? 1 : 0;
+      for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node) && budget > 0;
+           edge++) {
+        if (graph.getDest(edge) != NO_PAGE) {
+          count += counts[(budget - 1) * size + graph.getDest(edge)];
+        }
+      }
+      counts[budget * size + node] = count;
+    }
+  }
+  return counts;
+}
+
+bool sampleWalk(StoryGraph & graph, std::vector<long double> & counts, size_t budget,
+                uint64_t & state, std::vector<size_t> & pages) {
+  /*
+    Draw walk from page 0 to a win page with at most size_t budget choices,
+    uniformly among all such walks, stopping early if it revisits a page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<long double> & counts: walk counts from countWalks
+    size_t budget: maximum number of choices
+    uint64_t & state: random generator state
+    std::vector<size_t> & pages: filled with page sequence of walk
+
+    Return
+    ------
+    bool true if walk is a simple path
+  */
+  size_t size = graph.size();
+  size_t rows = counts.size() / size;
+  std::vector<char> onPath(size, 0);
+  size_t node = 0;
+  pages.assign(1, graph.toExternal(0));
+  onPath[0] = 1;
+  while (graph.getType(node) != 'W') {
+    // a uniform draw in [0, walks from node) picks each remaining walk equally
+    long double left = counts[std::min(budget, rows - 1) * size + node];
+    left *= (long double)(nextRandom(state) >> 11) / (long double)((uint64_t)1 << 53);
+    size_t row = std::min(budget - 1, rows - 1);
+    size_t next = NO_PAGE;
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (dest == NO_PAGE || counts[row * size + dest] == 0) {
+        continue;
+      }
+      next = dest;
+      if (left < counts[row * size + dest]) {
+        break;
+      }
+      left -= counts[row * size + dest];
+    }
+    if (next == NO_PAGE) {
+      return false;
+    }
+    node = next;
+    budget--;
+    pages.push_back(graph.toExternal(node));
+    if (onPath[node]) {
+      return false;
+    }
+    onPath[node] = 1;
+  }
+  return true;
+}
+
+void printSampledPaths(int argc, char ** argv) {
+  /*
+    Print winnable paths of Story drawn uniformly at random, exactly for acyclic
+    stories and by rejecting walks that revisit a page otherwise
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: number of paths (optional, default SAMPLE_DEFAULT_PATHS)
+      - argv[3]: random seed (optional, default 1)
+      - argv[4]: maximum number of choices per path (optional, default all paths
+        for acyclic stories, otherwise as many as SAMPLE_MAX_CELLS allows, halved
+        until at least SAMPLE_MIN_ACCEPT of pilot walks are simple paths but never
+        below the shortest winnable path; paths longer than the budget are never
+        drawn)
+
+    Return
+    ------
+    None
+  */
+  if (argc < 2 || argc > 5) {
+    std::cerr << "Usage: ./cyoa-sample <dir> [paths] [seed] [budget]\n";
+    exit(EXIT_FAILURE);
+  }
+  size_t numPaths = argc > 2 ? parseCount(argv[2]) : SAMPLE_DEFAULT_PATHS;
+  uint64_t state = seedRandom(argc > 3 ? parseCount(argv[3]) : 1);
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  StoryGraph graph(story);
+  size_t size = graph.size();
+  std::vector<size_t> order;
+  size_t budget = size;
+  size_t rows = 1;
+  if (argc > 4) {
+    budget = parseCount(argv[4]);
+    rows = budget + 1;
+  }
+  else if (!findTopoOrder(graph, order)) {
+    budget = std::min(size - 1, SAMPLE_MAX_CELLS / size - 1);
+    rows = budget + 1;
+  }
+  if (rows > SAMPLE_MAX_CELLS / size) {
+    std::cerr << "Budget too large: " << budget << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<long double> counts = countWalks(graph, rows);
+  std::vector<size_t> pages;
+  // halving stops at the shortest budget that still has walks to a win page
+  while (rows > 1 && argc <= 4 && budget > 1 && counts[(budget / 2) * size] != 0) {
+    uint64_t pilot = state;
+    size_t accepted = 0;
+    for (size_t i = 0; i < SAMPLE_PILOT_WALKS; i++) {
+      accepted += sampleWalk(graph, counts, budget, pilot, pages) ? 1 : 0;
+    }
+    if (accepted >= SAMPLE_PILOT_WALKS * SAMPLE_MIN_ACCEPT) {
+      break;
+    }
+    budget /= 2;
+    counts.resize((budget + 1) * size);
+  }
+  if (rows > 1 && argc <= 4 && budget < size - 1) {
+    std::cerr << "Sampling paths of at most " << budget
+              << " choices, uniformly among those paths only\n";
+  }
+  if (counts[std::min(budget, rows - 1) * size] == 0) {
+    if (argc > 4) {
+      std::cout << "No winnable path has at most " << budget << " choices!\n";
+    }
+    else {
+      std::cout << "This story is unwinnable!\n";
+    }
+    delete story;
+    return;
+  }
+  size_t tries = 0;
+  for (size_t i = 0; i < numPaths; i++) {
+    while (!sampleWalk(graph, counts, budget, state, pages)) {
+      if (++tries == SAMPLE_MAX_TRIES) {
+        std::cerr << "Too many walks revisit a page, try a smaller budget" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    if (pages.size() == 1) {
+      std::cout << pages[0] << "(win)\n";
+    }
+    else {
+      printPath(story, pages, std::cout);
+    }
+  }
+  std::cout.flush();
+  delete story;
+}
+
+// PATH ESTIMATE
+std::vector<bool> findWinReachable(StoryGraph & graph) {
+  /*
+    Return pages from which a Win page can be reached
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+
+    Return
+    ------
+    std::vector<bool> indicating for each internal node if a Win page is reachable
+    from it
+  */
+  std::vector<bool> live(graph.size(), false);
+  std::vector<size_t> queue;
+  for (size_t node = 0; node < graph.size(); node++) {
+    if (graph.getType(node) == 'W') {
+      live[node] = true;
+      queue.push_back(node);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    size_t node = queue[head];
+    for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+      size_t pred = graph.getPred(idx);
+      if (!live[pred]) {
+        live[pred] = true;
+        queue.push_back(pred);
+      }
+    }
+  }
+  return live;
+}
+
+long double probePaths(StoryGraph & graph, std::vector<bool> & live, uint64_t & state,
+                       std::vector<char> & onPath, std::vector<size_t> & edges) {
+  /*
+    Return Knuth estimate of number of winnable paths from one random probe down the
+    dfs search tree, choosing uniformly among choices that keep the path simple and
+    can still reach a Win page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<bool> & live: whether a Win page can be reached from each node
+    uint64_t & state: random generator state
+    std::vector<char> & onPath: all zero, used to mark pages on probe
+    std::vector<size_t> & edges: scratch space for candidate choices
+
+    Return
+    ------
+    long double product of branching factors summed over Win pages on probe
+  */
+  if (graph.size() == 0 || !live[0]) {
+    return 0;
+  }
+  std::vector<size_t> path(1, 0);
+  onPath[0] = 1;
+  long double weight = 1;
+  long double estimate = graph.getType(0) == 'W' ? 1 : 0;
+  size_t node = 0;
+  while (true) {
+    edges.clear();
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (dest != NO_PAGE && live[dest] && !onPath[dest]) {
+        edges.push_back(dest);
+      }
+    }
+    if (edges.empty()) {
+      break;
+    }
+    weight *= edges.size();
+    node = edges[randomIndex(state, edges.size())];
+    onPath[node] = 1;
+    path.push_back(node);
+    if (graph.getType(node) == 'W') {
+      estimate += weight;
+    }
+  }
+  std::vector<size_t>::iterator it = path.begin();
+  while (it != path.end()) {
+    onPath[*it] = 0;
+    ++it;
+  }
+  return estimate;
+}
+
+void printPathEstimate(int argc, char ** argv) {
+  /*
+    Print estimated number of winnable paths in Story with a 95% confidence interval,
+    averaging random probes of the dfs search tree for a fixed time
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: seconds to spend probing (optional, default ESTIMATE_SECONDS)
+      - argv[3]: random seed (optional, default 1)
+
+    Return
+    ------
+    None
+  */
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: ./cyoa-estimate <dir> [seconds] [seed]\n";
+    exit(EXIT_FAILURE);
+  }
+  size_t seconds = argc > 2 ? parseCount(argv[2]) : ESTIMATE_SECONDS;
+  uint64_t state = seedRandom(argc > 3 ? parseCount(argv[3]) : 1);
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  StoryGraph graph(story);
+  std::vector<bool> live = findWinReachable(graph);
+  std::vector<char> onPath(graph.size(), 0);
+  std::vector<size_t> edges;
+  // running mean and sum of squared deviations (Welford)
+  size_t probes = 0;
+  long double mean = 0;
+  long double squares = 0;
+  clock_t start = clock();
+  clock_t limit = (clock_t)(seconds * CLOCKS_PER_SEC);
+  do {
+    for (size_t i = 0; i < ESTIMATE_BATCH; i++) {
+      long double estimate = probePaths(graph, live, state, onPath, edges);
+      probes++;
+      long double delta = estimate - mean;
+      mean += delta / probes;
+      squares += delta * (estimate - mean);
+    }
+  } while (clock() - start < limit);
+  long double error = std::sqrt(squares / (probes - 1) / probes);
+  std::cout << "Probes: " << probes << "\n";
+  std::cout << "Estimated winnable paths: " << mean << "\n";
+  std::cout << "95% confidence interval: [" << std::max(mean - 1.96 * error, 0.0L) << ", "
+            << mean + 1.96 * error << "]\n";
+  std::cout.flush();
+  delete story;
+}
+
+//======================================================================
+
+PathZdd::PathZdd(StoryGraph & graph) :
+    vars(2, NO_PAGE),
+    los(2, 0),
+    his(2, 0),
+    unique(),
+    root(0) {
+  size_t numNodes = graph.size();
+  size_t numEdges = numNodes > 0 ? graph.lastEdge(numNodes - 1) : 0;
+  if (numNodes == 0) {
+    return;
+  }
+  if (graph.getType(0) == 'W') {
+    root = 1;
+    return;
+  }
+  std::vector<size_t> src(numEdges, 0);
+  std::vector<size_t> lastTouch(numNodes, 0);
+  std::vector<size_t> firstTouch(numNodes, NO_PAGE);
+  for (size_t node = 0; node < numNodes; node++) {
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      src[edge] = node;
+      size_t ends[2] = {node, graph.getDest(edge)};
+      for (int i = 0; i < 2; i++) {
+        if (ends[i] != NO_PAGE) {
+          firstTouch[ends[i]] = std::min(firstTouch[ends[i]], edge);
+          lastTouch[ends[i]] = edge;
+        }
+      }
+    }
+  }
+  // top-down construction, one level per edge; a state holds for each frontier
+  // page (sorted) the code (mate + 3) * 4 + in + 2 * out, where mate is the
+  // other end of its path fragment, ZDD_INTERIOR, ZDD_FROM_START or ZDD_TO_WIN
+  std::vector<size_t> frontier;
+  std::vector<size_t> nextFrontier;
+  std::map<std::vector<long>, size_t> level;
+  std::vector<std::vector<long> > states;
+  std::vector<size_t> buildVars(2, NO_PAGE);
+  std::vector<size_t> buildLos(2, 0);
+  std::vector<size_t> buildHis(2, 0);
+  std::vector<long> in(numNodes, 0);
+  std::vector<long> out(numNodes, 0);
+  std::vector<long> mate(numNodes, 0);
+  states.push_back(std::vector<long>());
+  std::vector<size_t> ids(1, 2);
+  buildVars.push_back(0);
+  buildLos.push_back(0);
+  buildHis.push_back(0);
+  for (size_t edge = 0; edge < numEdges && !states.empty(); edge++) {
+    size_t from = src[edge];
+    size_t to = graph.getDest(edge);
+    std::vector<size_t> entering;
+    if (firstTouch[from] == edge) {
+      entering.push_back(from);
+    }
+    if (to != NO_PAGE && to != from && firstTouch[to] == edge) {
+      entering.push_back(to);
+    }
+    std::vector<size_t> current(frontier);
+    current.insert(current.end(), entering.begin(), entering.end());
+    std::sort(current.begin(), current.end());
+    std::vector<size_t> leaving;
+    for (size_t i = 0; i < current.size(); i++) {
+      if (lastTouch[current[i]] == edge) {
+        leaving.push_back(current[i]);
+      }
+    }
+    nextFrontier.clear();
+    for (size_t i = 0; i < current.size(); i++) {
+      if (lastTouch[current[i]] > edge) {
+        nextFrontier.push_back(current[i]);
+      }
+    }
+    level.clear();
+    std::vector<std::vector<long> > nextStates;
+    std::vector<size_t> nextIds;
+    for (size_t idx = 0; idx < states.size(); idx++) {
+      for (int take = 0; take < 2; take++) {
+        // decode state over current frontier, entering pages start isolated
+        for (size_t i = 0; i < frontier.size(); i++) {
+          long code = states[idx][i];
+          in[frontier[i]] = code & 1;
+          out[frontier[i]] = (code >> 1) & 1;
+          mate[frontier[i]] = code / 4 - 3;
+        }
+        for (size_t i = 0; i < entering.size(); i++) {
+          in[entering[i]] = 0;
+          out[entering[i]] = 0;
+          mate[entering[i]] = entering[i];
+        }
+        size_t child = NO_PAGE;
+        if (take) {
+          child = takeZddEdge(graph, current, from, to, in, out, mate);
+        }
+        if (child == NO_PAGE) {
+          child = leaveZddFrontier(graph, current, leaving, in, out, mate);
+        }
+        if (child == NO_PAGE && edge + 1 == numEdges) {
+          child = 0;
+        }
+        if (child == NO_PAGE) {
+          std::vector<long> next;
+          next.reserve(nextFrontier.size());
+          for (size_t i = 0; i < nextFrontier.size(); i++) {
+            size_t page = nextFrontier[i];
+            next.push_back((mate[page] + 3) * 4 + in[page] + 2 * out[page]);
+          }
+          std::map<std::vector<long>, size_t>::iterator found = level.find(next);
+          if (found == level.end()) {
+            child = buildVars.size();
+            buildVars.push_back(edge + 1);
+            buildLos.push_back(0);
+            buildHis.push_back(0);
+            level[next] = child;
+            nextStates.push_back(next);
+            nextIds.push_back(child);
+          }
+          else {
+            child = found->second;
+          }
+        }
+        if (take) {
+          buildHis[ids[idx]] = child;
+        }
+        else {
+          buildLos[ids[idx]] = child;
+        }
+      }
+    }
+    frontier = nextFrontier;
+    states.swap(nextStates);
+    ids.swap(nextIds);
+  }
+  // bottom-up reduction; children were always created after their parents
+  std::vector<size_t> reduced(buildVars.size(), 0);
+  reduced[1] = 1;
+  for (size_t id = buildVars.size() - 1; id >= 2; id--) {
+    reduced[id] = makeNode(buildVars[id], reduced[buildLos[id]], reduced[buildHis[id]]);
+  }
+  root = reduced[2];
+}
+
+PathZdd::~PathZdd() {
+}
+
+size_t PathZdd::getRoot() const {
+  return root;
+}
+
+size_t PathZdd::size(size_t node) const {
+  std::vector<size_t> todo(1, node);
+  std::set<size_t> seen;
+  seen.insert(node);
+  while (!todo.empty()) {
+    size_t id = todo.back();
+    todo.pop_back();
+    if (id < 2) {
+      continue;
+    }
+    size_t children[2] = {los[id], his[id]};
+    for (int i = 0; i < 2; i++) {
+      if (seen.insert(children[i]).second) {
+        todo.push_back(children[i]);
+      }
+    }
+  }
+  return seen.size();
+}
+
+size_t PathZdd::makeNode(size_t var, size_t lo, size_t hi) {
+  if (hi == 0) {
+    return lo;
+  }
+  std::pair<size_t, std::pair<size_t, size_t> > key(var, std::make_pair(lo, hi));
+  std::map<std::pair<size_t, std::pair<size_t, size_t> >, size_t>::iterator it =
+      unique.find(key);
+  if (it != unique.end()) {
+    return it->second;
+  }
+  vars.push_back(var);
+  los.push_back(lo);
+  his.push_back(hi);
+  unique[key] = vars.size() - 1;
+  return vars.size() - 1;
+}
+
+std::string PathZdd::count(size_t node) const {
+  // base 10^9 limbs, least significant first
+  std::vector<std::vector<uint32_t> > counts(node + 1);
+  if (node >= 1) {
+    counts[1].push_back(1);
+  }
+  for (size_t id = 2; id <= node; id++) {
+    std::vector<uint32_t> & lo = counts[los[id]];
+    std::vector<uint32_t> & hi = counts[his[id]];
+    std::vector<uint32_t> & sum = counts[id];
+    uint32_t carry = 0;
+    for (size_t i = 0; i < std::max(lo.size(), hi.size()) || carry; i++) {
+      uint32_t limb = carry + (i < lo.size() ? lo[i] : 0) + (i < hi.size() ? hi[i] : 0);
+      carry = limb >= 1000000000 ? 1 : 0;
+      sum.push_back(limb - carry * 1000000000);
+    }
+  }
+  std::vector<uint32_t> & total = counts[node];
+  if (total.empty()) {
+    return "0";
+  }
+  std::stringstream ss;
+  ss << total.back();
+  for (size_t i = total.size() - 1; i > 0; i--) {
+    ss << std::setw(9) << std::setfill('0') << total[i - 1];
+  }
+  return ss.str();
+}
+
+bool PathZdd::contains(size_t node, std::vector<size_t> & edges) const {
+  std::vector<size_t>::iterator it = edges.begin();
+  while (node >= 2) {
+    if (it != edges.end() && *it < vars[node]) {
+      return false;
+    }
+    if (it != edges.end() && *it == vars[node]) {
+      node = his[node];
+      ++it;
+    }
+    else {
+      node = los[node];
+    }
+  }
+  return node == 1 && it == edges.end();
+}
+
+size_t PathZdd::filter(size_t node, std::vector<char> & marked, bool keep) {
+  // keep: sets that take a marked edge; !keep: sets that take none
+  if (node == 0) {
+    return 0;
+  }
+  std::vector<size_t> result(node + 1, 0);
+  result[1] = keep ? 0 : 1;
+  for (size_t id = 2; id <= node; id++) {
+    if (marked[vars[id]]) {
+      result[id] = keep ? makeNode(vars[id], result[los[id]], his[id])
+                        : result[los[id]];
+    }
+    else {
+      result[id] = makeNode(vars[id], result[los[id]], result[his[id]]);
+    }
+  }
+  return result[node];
+}
+
+void PathZdd::printPaths(Story * story, StoryGraph & graph, size_t node,
+                         std::ostream & out) const {
+  // depth-first over the diagram, taking each edge before leaving it out
+  std::vector<size_t> nodes(1, node);
+  std::vector<size_t> lengths(1, 0);
+  std::vector<size_t> edges;
+  std::vector<size_t> next(graph.size(), NO_PAGE);
+  std::vector<size_t> src;
+  for (size_t page = 0; page < graph.size(); page++) {
+    src.resize(graph.lastEdge(page), page);
+  }
+  while (!nodes.empty()) {
+    size_t id = nodes.back();
+    edges.resize(lengths.back());
+    nodes.pop_back();
+    lengths.pop_back();
+    if (id == 0) {
+      continue;
+    }
+    if (id == 1) {
+      std::vector<size_t>::iterator it = edges.begin();
+      while (it != edges.end()) {
+        next[src[*it]] = *it;
+        ++it;
+      }
+      std::vector<size_t> pages(1, graph.toExternal(0));
+      size_t page = 0;
+      for (size_t i = 0; i < edges.size(); i++) {
+        size_t edge = next[page];
+        next[page] = NO_PAGE;
+        page = graph.getDest(edge);
+        pages.push_back(graph.toExternal(page));
+      }
+      if (pages.size() == 1) {
+        out << pages[0] << "(win)\n";
+      }
+      else {
+        printPath(story, pages, out);
+      }
+      continue;
+    }
+    nodes.push_back(los[id]);
+    lengths.push_back(edges.size());
+    nodes.push_back(his[id]);
+    lengths.push_back(edges.size() + 1);
+    edges.push_back(vars[id]);
+  }
+}
+
+// PATH ZDD
+size_t takeZddEdge(StoryGraph & graph, std::vector<size_t> & current, size_t from,
+                   size_t to, std::vector<long> & in, std::vector<long> & out,
+                   std::vector<long> & mate) {
+  /*
+    Add edge from size_t from to size_t to to the path fragments in a ZDD frontier
+    state
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<size_t> & current: frontier pages
+    size_t from: source page of edge
+    size_t to: destination page of edge
+    std::vector<long> & in, & out, & mate: decoded state of each frontier page
+
+    Return
+    ------
+    size_t 0 if the edge cannot be on a winnable path, 1 if it completes one, or
+    NO_PAGE to continue with the updated state
+  */
+  if (to == NO_PAGE || to == from || to == 0 || out[from] || in[to]) {
+    return 0;
+  }
+  long head = in[from] ? mate[from] : (long)from;
+  long tail = out[to] ? mate[to] : (long)to;
+  if (head == (long)to) {
+    return 0;
+  }
+  out[from] = 1;
+  in[to] = 1;
+  bool fromStart = head == ZDD_FROM_START || head == 0;
+  bool toWin = tail == ZDD_TO_WIN || (tail >= 0 && graph.getType(tail) == 'W');
+  if (fromStart && toWin) {
+    // every other frontier page must be unused or inside this path
+    for (size_t i = 0; i < current.size(); i++) {
+      size_t page = current[i];
+      if (in[page] + out[page] == 1 && (long)page != head && (long)page != tail) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+  if (in[from]) {
+    mate[from] = ZDD_INTERIOR;
+  }
+  if (out[to]) {
+    mate[to] = ZDD_INTERIOR;
+  }
+  if (head >= 0) {
+    mate[head] = tail >= 0 ? tail : ZDD_TO_WIN;
+  }
+  if (tail >= 0) {
+    mate[tail] = head >= 0 ? head : ZDD_FROM_START;
+  }
+  if (head >= 0 && tail < 0) {
+    for (size_t i = 0; i < current.size(); i++) {
+      if (mate[current[i]] == ZDD_TO_WIN && (long)current[i] != head) {
+        return 0;
+      }
+    }
+  }
+  return NO_PAGE;
+}
+
+size_t leaveZddFrontier(StoryGraph & graph, std::vector<size_t> & current,
+                        std::vector<size_t> & leaving, std::vector<long> & in,
+                        std::vector<long> & out, std::vector<long> & mate) {
+  /*
+    Remove pages with no edges left from a ZDD frontier state, anchoring fragments
+    that start at page 0 or end at a win page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<size_t> & current: frontier pages
+    std::vector<size_t> & leaving: frontier pages with no edges left
+    std::vector<long> & in, & out, & mate: decoded state of each frontier page
+
+    Return
+    ------
+    size_t 0 if no winnable path can follow, or NO_PAGE to continue
+  */
+  std::vector<size_t>::iterator it = leaving.begin();
+  while (it != leaving.end()) {
+    size_t page = *it;
+    long partner = mate[page];
+    if (page == 0 && !out[page]) {
+      return 0;
+    }
+    if (out[page] && !in[page]) {
+      if (page != 0) {
+        return 0;
+      }
+      if (partner >= 0) {
+        mate[partner] = ZDD_FROM_START;
+      }
+    }
+    else if (in[page] && !out[page]) {
+      if (graph.getType(page) != 'W') {
+        return 0;
+      }
+      if (partner >= 0) {
+        for (size_t i = 0; i < current.size(); i++) {
+          if (mate[current[i]] == ZDD_TO_WIN) {
+            return 0;
+          }
+        }
+        mate[partner] = ZDD_TO_WIN;
+      }
+    }
+    in[page] = 0;
+    out[page] = 0;
+    mate[page] = ZDD_INTERIOR;
+    ++it;
+  }
+  return NO_PAGE;
+}
+
+bool parseZddPath(StoryGraph & graph, std::string & line, std::vector<size_t> & edges) {
+  /*
+    Parse path in printPath format into the sorted edges it takes
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::string & line: path such as 0(1),3(2),5(win)
+    std::vector<size_t> & edges: filled with sorted edges taken by path
+
+    Return
+    ------
+    bool true if line is a path from page 0 to a win page of story graph
+  */
+  edges.clear();
+  std::stringstream ss(line);
+  std::string step;
+  size_t node = 0;
+  bool first = true;
+  while (getline(ss, step, ',')) {
+    size_t open = step.find("(");
+    char * end = NULL;
+    size_t pagenum = std::strtoul(step.c_str(), &end, 10);
+    if (open == std::string::npos || end != step.c_str() + open || open == 0 ||
+        step[step.size() - 1] != ')' || graph.toInternal(pagenum) != node ||
+        (first && pagenum != 0)) {
+      return false;
+    }
+    first = false;
+    std::string choice = step.substr(open + 1, step.size() - open - 2);
+    if (!choice.compare("win")) {
+      std::sort(edges.begin(), edges.end());
+      return graph.getType(node) == 'W' && ss.peek() == EOF;
+    }
+    size_t num = std::strtoul(choice.c_str(), &end, 10);
+    if (choice.empty() || *end != '\0' || num == 0 ||
+        num > graph.lastEdge(node) - graph.firstEdge(node)) {
+      return false;
+    }
+    edges.push_back(graph.firstEdge(node) + num - 1);
+    node = graph.getDest(edges.back());
+    if (node == NO_PAGE) {
+      return false;
+    }
+  }
+  return false;
+}
+
+void printZddPaths(int argc, char ** argv) {
+  /*
+    Build winnable paths of Story as a ZDD and print its size and path count, every
+    path with -l, or whether a path is winnable with -m, after page constraints
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - +<page>: page every path must visit (optional, repeatable)
+      - -<page>: page no path may visit (optional, repeatable)
+      - -l: print every path (optional)
+      - -m <path>: print whether path in printPath format is a winnable path
+        meeting the constraints (optional)
+
+    Return
+    ------
+    None
+  */
+  if (argc < 2) {
+    std::cerr << "Usage: ./cyoa-zdd <dir> [+page] [-page] ... [-l | -m <path>]\n";
+    exit(EXIT_FAILURE);
+  }
+  std::vector<size_t> must;
+  std::vector<size_t> avoid;
+  bool list = false;
+  char * member = NULL;
+  for (int i = 2; i < argc; i++) {
+    if (!strcmp(argv[i], "-l")) {
+      list = true;
+    }
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+      member = argv[++i];
+    }
+    else if (!parseConstraint(argv[i], must, avoid)) {
+      std::cerr << "Invalid Constraint: " << argv[i] << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  checkConstraints(story, must, avoid);
+  StoryGraph graph(story);
+  PathZdd zdd(graph);
+  size_t node = zdd.getRoot();
+  size_t numEdges = graph.size() > 0 ? graph.lastEdge(graph.size() - 1) : 0;
+  // a path visits a page other than page 0 exactly when it takes an edge into it
+  for (size_t i = 0; i < must.size() + avoid.size(); i++) {
+    bool keep = i < must.size();
+    size_t page = graph.toInternal(keep ? must[i] : avoid[i - must.size()]);
+    if (page == 0) {
+      node = keep ? node : 0;
+      continue;
+    }
+    std::vector<char> marked(numEdges, 0);
+    for (size_t edge = 0; edge < numEdges; edge++) {
+      marked[edge] = graph.getDest(edge) == page;
+    }
+    node = zdd.filter(node, marked, keep);
+  }
+  if (member != NULL) {
+    std::string line(member);
+    std::vector<size_t> edges;
+    bool found = parseZddPath(graph, line, edges) && zdd.contains(node, edges);
+    std::cout << (found ? "yes" : "no") << "\n";
+  }
+  else if (list) {
+    zdd.printPaths(story, graph, node, std::cout);
+  }
+  else {
+    std::cout << "ZDD nodes: " << zdd.size(node) << "\n";
+    std::cout << "Winnable paths: " << zdd.count(node) << "\n";
+  }
+  std::cout.flush();
+  delete story;
+}
+
+// SHARDED PATHS
+std::vector<std::vector<size_t> > splitPaths(StoryGraph & graph, size_t numUnits) {
+  /*
+    Split the dfs search tree into at least size_t numUnits subtrees where possible,
+    each given by the choices from page 0 to its root, in the order dfs visits them
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    size_t numUnits: number of subtrees wanted
+
+    Return
+    ------
+    std::vector<std::vector<size_t> > choice numbers leading to each subtree root
+  */
+  std::vector<bool> live = findWinReachable(graph);
+  std::vector<std::vector<size_t> > units;
+  if (graph.size() == 0 || !live[0]) {
+    return units;
+  }
+  units.push_back(std::vector<size_t>());
+  std::vector<char> onPath(graph.size(), 0);
+  bool grown = true;
+  while (units.size() < numUnits && grown) {
+    grown = false;
+    std::vector<std::vector<size_t> > next;
+    std::vector<std::vector<size_t> >::iterator it = units.begin();
+    while (it != units.end()) {
+      std::vector<size_t> nodes(1, 0);
+      for (size_t i = 0; i < it->size(); i++) {
+        nodes.push_back(graph.getDest(graph.firstEdge(nodes.back()) + (*it)[i] - 1));
+      }
+      size_t node = nodes.back();
+      if (graph.getType(node) == 'W') {
+        next.push_back(*it);
+        ++it;
+        continue;
+      }
+      for (size_t i = 0; i < nodes.size(); i++) {
+        onPath[nodes[i]] = 1;
+      }
+      // dfs explores choices last to first
+      for (size_t edge = graph.lastEdge(node); edge > graph.firstEdge(node); edge--) {
+        size_t dest = graph.getDest(edge - 1);
+        if (dest != NO_PAGE && live[dest] && !onPath[dest]) {
+          next.push_back(*it);
+          next.back().push_back(edge - graph.firstEdge(node));
+          grown = true;
+        }
+      }
+      for (size_t i = 0; i < nodes.size(); i++) {
+        onPath[nodes[i]] = 0;
+      }
+      ++it;
+    }
+    units.swap(next);
+  }
+  return units;
+}
+
+size_t printPrefixPaths(Story * story, StoryGraph & graph, std::vector<size_t> & choices,
+                        size_t to, std::ostream & out) {
+  /*
+    Print winnable paths to win page size_t to that start with the given choices
+    from page 0, in the same order as dfs
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    StoryGraph & graph: renumbered story graph
+    std::vector<size_t> & choices: choice numbers from page 0 shared by every path
+    size_t to: number of win Page
+    std::ostream & out: stream to print paths to
+
+    Return
+    ------
+    size_t number of paths printed
+  */
+  size_t target = graph.toInternal(to);
+  std::vector<char> onPath(graph.size(), 0);
+  std::vector<size_t> path(1, 0);
+  std::vector<size_t> nodes(1, 0);
+  onPath[0] = 1;
+  for (size_t i = 0; i < choices.size(); i++) {
+    nodes.push_back(graph.getDest(graph.firstEdge(nodes.back()) + choices[i] - 1));
+    onPath[nodes.back()] = 1;
+    path.push_back(graph.toExternal(nodes.back()));
+  }
+  if (nodes.back() == target) {
+    printPath(story, path, out);
+    return 1;
+  }
+  size_t numPaths = 0;
+  size_t depth = nodes.size();
+  std::vector<size_t> remaining(depth, 0);
+  remaining.back() = graph.lastEdge(nodes.back()) - graph.firstEdge(nodes.back());
+  while (nodes.size() >= depth) {
+    size_t node = nodes.back();
+    if (remaining.back() == 0) {
+      if (nodes.size() > depth) {
+        onPath[node] = 0;
+        path.pop_back();
+      }
+      nodes.pop_back();
+      remaining.pop_back();
+      continue;
+    }
+    size_t dest = graph.getDest(graph.firstEdge(node) + --remaining.back());
+    if (dest == NO_PAGE || onPath[dest]) {
+      continue;
+    }
+    onPath[dest] = 1;
+    path.push_back(graph.toExternal(dest));
+    if (dest == target) {
+      printPath(story, path, out);
+      numPaths++;
+    }
+    nodes.push_back(dest);
+    remaining.push_back(graph.lastEdge(dest) - graph.firstEdge(dest));
+  }
+  return numPaths;
+}
+
+void writeManifest(char * file, char * dir, uint64_t hash, size_t numShards,
+                   std::vector<std::vector<size_t> > & units) {
+  /*
+    Write shard manifest assigning contiguous runs of subtrees to each shard
+      - cyoa-shard <story hash> <number of shards> <absolute story directory>
+      - one line per subtree: <shard> <choice> <choice> ...
+
+    Arguments
+    ---------
+    char * file: path to manifest
+    char * dir: directory with story.txt file
+    uint64_t hash: hash of Story graph structure
+    size_t numShards: number of shards
+    std::vector<std::vector<size_t> > & units: choices leading to each subtree
+
+    Return
+    ------
+    None
+  */
+  // workers may run from another directory, so the story directory is made absolute
+  char * absDir = realpath(dir, NULL);
+  if (absDir == NULL) {
+    std::cerr << "Failed to resolve " << dir << ": " << strerror(errno) << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::ofstream outfile(file);
+  if (!outfile.good()) {
+    std::cerr << "Failed to write " << file << std::endl;
+    free(absDir);
+    exit(EXIT_FAILURE);
+  }
+  outfile << "cyoa-shard " << std::hex << hash << std::dec << " " << numShards << " "
+          << absDir << "\n";
+  free(absDir);
+  for (size_t i = 0; i < units.size(); i++) {
+    outfile << i * numShards / units.size();
+    for (size_t j = 0; j < units[i].size(); j++) {
+      outfile << " " << units[i][j];
+    }
+    outfile << "\n";
+  }
+}
+
+void readManifest(char * file, std::string & dir, uint64_t & hash, size_t & numShards,
+                  std::vector<std::vector<size_t> > & units, std::vector<size_t> & owners) {
+  /*
+    Read shard manifest written by writeManifest; a relative story directory is
+    taken relative to the directory holding the manifest
+
+    Arguments
+    ---------
+    char * file: path to manifest
+    std::string & dir: filled with directory with story.txt file
+    uint64_t & hash: filled with hash of Story graph structure
+    size_t & numShards: filled with number of shards
+    std::vector<std::vector<size_t> > & units: filled with choices leading to each
+    subtree
+    std::vector<size_t> & owners: filled with shard of each subtree
+
+    Return
+    ------
+    None
+  */
+  std::string path(file);
+  std::ifstream infile(file);
+  checkInfile(infile, path);
+  std::string line;
+  std::string magic;
+  getline(infile, line);
+  std::stringstream header(line);
+  if (!(header >> magic >> std::hex >> hash >> std::dec >> numShards) ||
+      magic.compare("cyoa-shard") || numShards == 0) {
+    std::cerr << "Invalid Manifest: " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  header.get();
+  getline(header, dir);
+  size_t slash = path.rfind('/');
+  if (!dir.empty() && dir[0] != '/' && slash != path.npos) {
+    dir = path.substr(0, slash + 1) + dir;
+  }
+  while (getline(infile, line)) {
+    std::stringstream ss(line);
+    size_t owner = 0;
+    size_t choice = 0;
+    if (!(ss >> owner) || owner >= numShards) {
+      std::cerr << "Invalid Manifest: " << file << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    owners.push_back(owner);
+    units.push_back(std::vector<size_t>());
+    while (ss >> choice) {
+      units.back().push_back(choice);
+    }
+  }
+}
+
+std::string getShardFile(char * manifest, size_t shard) {
+  /*
+    Return path of output file for size_t shard next to manifest
+
+    Arguments
+    ---------
+    char * manifest: path to manifest
+    size_t shard: shard number
+
+    Return
+    ------
+    std::string path to shard output file
+  */
+  std::stringstream ss;
+  ss << manifest << "." << shard << ".out";
+  return ss.str();
+}
+
+void runShard(Story * story, StoryGraph & graph, std::vector<std::vector<size_t> > & units,
+              std::vector<size_t> & owners, size_t shard, std::string & file) {
+  /*
+    Print winnable paths in subtrees of size_t shard to output file, in one section
+    per win page
+      - # win <page>
+      - paths in printPath format
+      - # end
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    StoryGraph & graph: renumbered story graph
+    std::vector<std::vector<size_t> > & units: choices leading to each subtree
+    std::vector<size_t> & owners: shard of each subtree
+    size_t shard: shard number
+    std::string & file: path to shard output file
+
+    Return
+    ------
+    None
+  */
+  std::string tmp = getTempFile(file);
+  std::ofstream outfile(tmp.c_str());
+  if (!outfile.good()) {
+    std::cerr << "Failed to write " << tmp << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::string win("W");
+  std::set<size_t> winpages = story->getPagetypes(win);
+  std::set<size_t>::iterator it = winpages.begin();
+  while (it != winpages.end()) {
+    outfile << "# win " << *it << "\n";
+    for (size_t i = 0; i < units.size(); i++) {
+      if (owners[i] == shard) {
+        printPrefixPaths(story, graph, units[i], *it, outfile);
+      }
+    }
+    outfile << "# end\n";
+    ++it;
+  }
+  outfile.close();
+  if (outfile.fail() || rename(tmp.c_str(), file.c_str()) != 0) {
+    std::cerr << "Failed to write " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+void mergeShards(char * manifest, size_t numShards) {
+  /*
+    Print winnable paths from every shard output file, grouped by win page and in
+    dfs order, as printAllPaths does
+
+    Arguments
+    ---------
+    char * manifest: path to manifest
+    size_t numShards: number of shards
+
+    Return
+    ------
+    None
+  */
+  std::vector<std::ifstream *> infiles;
+  for (size_t shard = 0; shard < numShards; shard++) {
+    std::string file = getShardFile(manifest, shard);
+    infiles.push_back(new std::ifstream(file.c_str()));
+    checkInfile(*infiles.back(), file);
+  }
+  size_t numPaths = 0;
+  std::string line;
+  std::string header;
+  while (getline(*infiles[0], header)) {
+    for (size_t shard = 0; shard < numShards; shard++) {
+      if (shard > 0 && (!getline(*infiles[shard], line) || line != header)) {
+        std::cerr << "Invalid Shard Output: " << getShardFile(manifest, shard)
+                  << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      while (getline(*infiles[shard], line) && line.compare("# end")) {
+        std::cout << line << "\n";
+        numPaths++;
+      }
+    }
+  }
+  for (size_t shard = 0; shard < numShards; shard++) {
+    delete infiles[shard];
+  }
+  if (numPaths == 0) {
+    std::cout << "This story is unwinnable!\n";
+  }
+  std::cout.flush();
+}
+
+void printShardedPaths(int argc, char ** argv) {
+  /*
+    Split, run, and merge winnable path enumeration by shards of the dfs search tree
+      - split <dir> <shards> <manifest>: write manifest
+      - work <manifest> <shard>: write paths of one shard next to manifest
+      - merge <manifest>: print paths of every shard as printAllPaths does
+      - run <dir> <shards> <manifest>: split, fork one worker per shard, and merge
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+
+    Return
+    ------
+    None
+  */
+  std::string mode(argc > 1 ? argv[1] : "");
+  bool split = (!mode.compare("split") || !mode.compare("run")) && argc == 5;
+  if (!split && !(!mode.compare("work") && argc == 4) &&
+      !(!mode.compare("merge") && argc == 3)) {
+    std::cerr << "Usage: ./cyoa-shard split|run <dir> <shards> <manifest>\n"
+              << "       ./cyoa-shard work <manifest> <shard>\n"
+              << "       ./cyoa-shard merge <manifest>\n";
+    exit(EXIT_FAILURE);
+  }
+  if (split) {
+    size_t numShards = std::max((size_t)1, parseCount(argv[3]));
+    Story * story = buildStory(argv[2]);
+    checkStory(story);
+    StoryGraph graph(story);
+    std::vector<std::vector<size_t> > units =
+        splitPaths(graph, numShards * SHARD_UNITS_PER_WORKER);
+    writeManifest(argv[4], argv[2], hashStory(story), numShards, units);
+    if (!mode.compare("split")) {
+      delete story;
+      return;
+    }
+    std::vector<size_t> owners;
+    for (size_t i = 0; i < units.size(); i++) {
+      owners.push_back(i * numShards / units.size());
+    }
+    std::cout.flush();
+    std::vector<pid_t> workers;
+    for (size_t shard = 0; shard < numShards; shard++) {
+      pid_t pid = fork();
+      if (pid < 0) {
+        std::cerr << "Failed to start shard worker" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      if (pid == 0) {
+        std::string file = getShardFile(argv[4], shard);
+        runShard(story, graph, units, owners, shard, file);
+        _exit(EXIT_SUCCESS);
+      }
+      workers.push_back(pid);
+    }
+    bool failed = false;
+    for (size_t i = 0; i < workers.size(); i++) {
+      int status = 0;
+      if (waitpid(workers[i], &status, 0) < 0 || !WIFEXITED(status) ||
+          WEXITSTATUS(status) != EXIT_SUCCESS) {
+        failed = true;
+      }
+    }
+    if (failed) {
+      std::cerr << "Shard worker failed" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    mergeShards(argv[4], numShards);
+    delete story;
+    return;
+  }
+  std::string dir;
+  uint64_t hash = 0;
+  size_t numShards = 0;
+  std::vector<std::vector<size_t> > units;
+  std::vector<size_t> owners;
+  readManifest(argv[2], dir, hash, numShards, units, owners);
+  if (!mode.compare("merge")) {
+    mergeShards(argv[2], numShards);
+    return;
+  }
+  size_t shard = parseCount(argv[3]);
+  if (shard >= numShards) {
+    std::cerr << "Invalid Shard: " << argv[3] << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<char> path(dir.begin(), dir.end());
+  path.push_back('\0');
+  Story * story = buildStory(&path[0]);
+  if (hashStory(story) != hash) {
+    std::cerr << "Story Mismatch: " << dir << " has changed since the manifest was written"
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  checkStory(story);
+  StoryGraph graph(story);
+  std::string file = getShardFile(argv[2], shard);
+  runShard(story, graph, units, owners, shard, file);
+  delete story;
+}
+
+// INCREMENTAL PATHS
+void collectEdges(StoryGraph & graph, std::map<std::pair<size_t, size_t>, size_t> & edges,
+                  std::set<size_t> & winpages) {
+  /*
+    Collect every choice of the story graph by page number and choice number, and
+    its Win pages
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::map<std::pair<size_t, size_t>, size_t> & edges: filled with destination page
+    of each (page, choice)
+    std::set<size_t> & winpages: filled with page numbers of Win pages
+
+    Return
+    ------
+    None
+  */
+  for (size_t node = 0; node < graph.size(); node++) {
+    size_t pagenum = graph.toExternal(node);
+    if (graph.getType(node) == 'W') {
+      winpages.insert(pagenum);
+    }
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      size_t dest = graph.getDest(edge);
+      if (dest != NO_PAGE) {
+        std::pair<size_t, size_t> key(pagenum, edge - graph.firstEdge(node) + 1);
+        edges[key] = graph.toExternal(dest);
+      }
+    }
+  }
+}
+
+bool readIncrState(char * file, uint64_t & hash,
+                   std::map<std::pair<size_t, size_t>, size_t> & edges,
+                   std::set<size_t> & winpages, std::vector<std::string> & paths) {
+  /*
+    Read state file written by writeIncrState
+      - cyoa-incr <story hash>
+      - win <page>
+      - edge <page> <choice> <destination page>
+      - path <path in printPlaythrough format>
+
+    Arguments
+    ---------
+    char * file: path to state file
+    uint64_t & hash: filled with hash of Story graph structure
+    std::map<std::pair<size_t, size_t>, size_t> & edges: filled with destination page
+    of each (page, choice)
+    std::set<size_t> & winpages: filled with page numbers of Win pages
+    std::vector<std::string> & paths: filled with winnable paths
+
+    Return
+    ------
+    bool false if there is no state file yet
+  */
+  std::ifstream infile(file);
+  if (!infile.good()) {
+    return false;
+  }
+  std::string line;
+  std::string kind;
+  getline(infile, line);
+  std::stringstream header(line);
+  if (!(header >> kind >> std::hex >> hash) || kind.compare("cyoa-incr")) {
+    std::cerr << "Invalid State File: " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  while (getline(infile, line)) {
+    std::stringstream ss(line);
+    ss >> kind;
+    if (!kind.compare("path")) {
+      paths.push_back(line.substr(5));
+      continue;
+    }
+    size_t pagenum = 0;
+    size_t choice = 0;
+    size_t dest = 0;
+    if (!kind.compare("win") && ss >> pagenum) {
+      winpages.insert(pagenum);
+    }
+    else if (!kind.compare("edge") && ss >> pagenum >> choice >> dest) {
+      edges[std::pair<size_t, size_t>(pagenum, choice)] = dest;
+    }
+    else {
+      std::cerr << "Invalid State File: " << file << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  return true;
+}
+
+void writeIncrState(char * file, uint64_t hash,
+                    std::map<std::pair<size_t, size_t>, size_t> & edges,
+                    std::set<size_t> & winpages, std::vector<std::string> & paths) {
+  /*
+    Write state file read by readIncrState, replacing any previous one only once it
+    is complete
+
+    Arguments
+    ---------
+    char * file: path to state file
+    uint64_t hash: hash of Story graph structure
+    std::map<std::pair<size_t, size_t>, size_t> & edges: destination page of each
+    (page, choice)
+    std::set<size_t> & winpages: page numbers of Win pages
+    std::vector<std::string> & paths: winnable paths
+
+    Return
+    ------
+    None
+  */
+  std::string tmp = getTempFile(file);
+  std::ofstream outfile(tmp.c_str());
+  outfile << "cyoa-incr " << std::hex << hash << std::dec << "\n";
+  std::set<size_t>::iterator winIt = winpages.begin();
+  while (winIt != winpages.end()) {
+    outfile << "win " << *winIt << "\n";
+    ++winIt;
+  }
+  std::map<std::pair<size_t, size_t>, size_t>::iterator edgeIt = edges.begin();
+  while (edgeIt != edges.end()) {
+    outfile << "edge " << edgeIt->first.first << " " << edgeIt->first.second << " "
+            << edgeIt->second << "\n";
+    ++edgeIt;
+  }
+  std::vector<std::string>::iterator pathIt = paths.begin();
+  while (pathIt != paths.end()) {
+    outfile << "path " << *pathIt << "\n";
+    ++pathIt;
+  }
+  outfile.close();
+  if (outfile.fail() || rename(tmp.c_str(), file) != 0) {
+    std::cerr << "Failed to write " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+bool isPathIntact(StoryGraph & graph, std::string & path) {
+  /*
+    Return whether every choice taken by a path still exists and its last page is
+    still a Win page
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::string & path: path in printPlaythrough format such as 0(1),3(2),5(win)
+
+    Return
+    ------
+    bool true if path is still winnable in story graph
+  */
+  std::stringstream ss(path);
+  std::string step;
+  size_t node = 0;
+  while (getline(ss, step, ',')) {
+    char * end = NULL;
+    size_t pagenum = std::strtoul(step.c_str(), &end, 10);
+    if (graph.toInternal(pagenum) != node || node == NO_PAGE || *end != '(') {
+      return false;
+    }
+    if (!step.compare(end - step.c_str(), std::string::npos, "(win)")) {
+      return graph.getType(node) == 'W' && ss.eof();
+    }
+    size_t choice = std::strtoul(end + 1, NULL, 10);
+    if (choice == 0 || choice > graph.lastEdge(node) - graph.firstEdge(node)) {
+      return false;
+    }
+    node = graph.getDest(graph.firstEdge(node) + choice - 1);
+  }
+  return false;
+}
+
+void findTouchedPaths(StoryGraph & graph, std::vector<bool> & changed,
+                      std::vector<bool> & newWins, std::vector<std::string> & paths) {
+  /*
+    Find winnable paths that take a changed choice or end at a new Win page, without
+    exploring the parts of the story that lead to neither
+
+    Arguments
+    ---------
+    StoryGraph & graph: renumbered story graph
+    std::vector<bool> & changed: indicates for each edge if it is new or now leads
+    elsewhere
+    std::vector<bool> & newWins: indicates for each node if it became a Win page
+    std::vector<std::string> & paths: filled with touched paths in printPlaythrough
+    format
+
+    Return
+    ------
+    None
+  */
+  if (graph.size() == 0) {
+    return;
+  }
+  std::vector<bool> live = findWinReachable(graph);
+  // nodes that can still reach a changed choice or new Win page
+  std::vector<bool> canTouch(graph.size(), false);
+  std::vector<size_t> queue;
+  for (size_t node = 0; node < graph.size(); node++) {
+    bool touches = newWins[node];
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      touches = touches || changed[edge];
+    }
+    if (touches) {
+      canTouch[node] = true;
+      queue.push_back(node);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    size_t node = queue[head];
+    for (size_t idx = graph.firstPred(node); idx < graph.lastPred(node); idx++) {
+      if (!canTouch[graph.getPred(idx)]) {
+        canTouch[graph.getPred(idx)] = true;
+        queue.push_back(graph.getPred(idx));
+      }
+    }
+  }
+  if (!canTouch[0] || !live[0]) {
+    return;
+  }
+  std::vector<char> onPath(graph.size(), 0);
+  std::vector<size_t> nodes(1, 0);
+  std::vector<size_t> next(1, graph.firstEdge(0));
+  std::vector<size_t> edges;
+  // number of changed choices on the path so far
+  std::vector<size_t> touched(1, 0);
+  onPath[0] = 1;
+  while (!nodes.empty()) {
+    size_t node = nodes.back();
+    if (graph.getType(node) == 'W' && next.back() == graph.firstEdge(node) &&
+        (touched.back() > 0 || newWins[node])) {
+      std::stringstream ss;
+      printPlaythrough(graph, edges, ss);
+      paths.push_back(ss.str().substr(0, ss.str().size() - 1));
+    }
+    if (next.back() == graph.lastEdge(node)) {
+      onPath[node] = 0;
+      nodes.pop_back();
+      next.pop_back();
+      touched.pop_back();
+      if (!edges.empty()) {
+        edges.pop_back();
+      }
+      continue;
+    }
+    size_t edge = next.back()++;
+    size_t dest = graph.getDest(edge);
+    if (dest == NO_PAGE || onPath[dest] || !live[dest]) {
+      continue;
+    }
+    size_t count = touched.back() + (changed[edge] ? 1 : 0);
+    if (count == 0 && !canTouch[dest]) {
+      continue;
+    }
+    onPath[dest] = 1;
+    nodes.push_back(dest);
+    next.push_back(graph.firstEdge(dest));
+    touched.push_back(count);
+    edges.push_back(edge);
+  }
+}
+
+void printIncrPaths(int argc, char ** argv) {
+  /*
+    Print winnable paths added and removed since the state file was last written,
+    recomputing only paths that take a changed choice, and update the state file
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+
+    Return
+    ------
+    None
+  */
+  if (argc != 3) {
+    std::cerr << "Usage: ./cyoa-incr <dir> <state file>\n";
+    exit(EXIT_FAILURE);
+  }
+  Story * story = buildStory(argv[1]);
+  checkStory(story);
+  StoryGraph graph(story);
+  uint64_t hash = hashStory(story);
+  uint64_t oldHash = 0;
+  std::map<std::pair<size_t, size_t>, size_t> oldEdges;
+  std::set<size_t> oldWins;
+  std::vector<std::string> oldPaths;
+  bool hasState = readIncrState(argv[2], oldHash, oldEdges, oldWins, oldPaths);
+  if (hasState && oldHash == hash) {
+    std::cout << "0 paths added, 0 paths removed, " << oldPaths.size()
+              << " winnable paths\n";
+    delete story;
+    return;
+  }
+  std::map<std::pair<size_t, size_t>, size_t> edges;
+  std::set<size_t> winpages;
+  collectEdges(graph, edges, winpages);
+  std::vector<bool> changed(graph.size() == 0 ? 0 : graph.lastEdge(graph.size() - 1),
+                            false);
+  std::vector<bool> newWins(graph.size(), false);
+  for (size_t node = 0; node < graph.size(); node++) {
+    size_t pagenum = graph.toExternal(node);
+    newWins[node] = graph.getType(node) == 'W' && oldWins.count(pagenum) == 0;
+    for (size_t edge = graph.firstEdge(node); edge < graph.lastEdge(node); edge++) {
+      std::pair<size_t, size_t> key(pagenum, edge - graph.firstEdge(node) + 1);
+      std::map<std::pair<size_t, size_t>, size_t>::iterator old = oldEdges.find(key);
+      changed[edge] = graph.getDest(edge) != NO_PAGE &&
+                      (old == oldEdges.end() || old->second != edges[key]);
+    }
+  }
+  std::vector<std::string> paths;
+  size_t numRemoved = 0;
+  std::vector<std::string>::iterator it = oldPaths.begin();
+  while (it != oldPaths.end()) {
+    if (isPathIntact(graph, *it)) {
+      paths.push_back(*it);
+    }
+    else {
+      std::cout << "- " << *it << "\n";
+      numRemoved++;
+    }
+    ++it;
+  }
+  std::vector<std::string> added;
+  findTouchedPaths(graph, changed, newWins, added);
+  it = added.begin();
+  while (it != added.end()) {
+    std::cout << "+ " << *it << "\n";
+    paths.push_back(*it);
+    ++it;
+  }
+  std::cout << added.size() << " paths added, " << numRemoved << " paths removed, "
+            << paths.size() << " winnable paths\n";
+  std::cout.flush();
+  writeIncrState(argv[2], hash, edges, winpages, paths);
+  delete story;
+}
+
+//======================================================================
+
+StateSpace::StateSpace(Story * story) :
+    values(story->getVarNames().size(), std::vector<long int>(1, 0)),
+    words(),
+    shifts(),
+    bits(),
+    width(1),
+    keys(),
+    slots(1024, NO_STATE),
+    scratch() {
+  std::vector<std::string> & vars = story->getVars();
+  std::vector<std::string>::iterator it = vars.begin();
+  while (it != vars.end()) {
+    std::string var = story->parseVar(*it);
+    values[story->getVarId(var)].push_back(story->parseVal(*it));
+    ++it;
+  }
+  size_t used = 64;
+  for (size_t var = 0; var < values.size(); var++) {
+    std::sort(values[var].begin(), values[var].end());
+    values[var].erase(std::unique(values[var].begin(), values[var].end()),
+                      values[var].end());
+    size_t numBits = 0;
+    while (((size_t)1 << numBits) < values[var].size()) {
+      numBits++;
+    }
+    // a variable with one value needs no bits and is never encoded
+    if (numBits == 0) {
+      words.push_back(0);
+      shifts.push_back(0);
+      bits.push_back(0);
+      continue;
+    }
+    if (used == 64 || used + numBits > 64) {
+      width++;
+      used = 0;
+    }
+    words.push_back(width - 1);
+    shifts.push_back(used);
+    bits.push_back(numBits);
+    used += numBits;
+  }
+  scratch.resize(width);
+}
+
+StateSpace::~StateSpace() {
+}
+
+size_t StateSpace::size() const {
+  return keys.size() / width;
+}
+
+size_t StateSpace::getWidth() const {
+  return width;
+}
+
+void StateSpace::encode(size_t pagenum,
+                        std::vector<long int> & memory,
+                        uint64_t * key) const {
+  key[0] = pagenum;
+  for (size_t word = 1; word < width; word++) {
+    key[word] = 0;
+  }
+  for (size_t var = 0; var < values.size(); var++) {
+    if (bits[var] == 0) {
+      continue;
+    }
+    uint64_t idx = std::lower_bound(values[var].begin(), values[var].end(), memory[var]) -
+                   values[var].begin();
+    key[words[var]] |= idx << shifts[var];
+  }
+}
+
+uint64_t StateSpace::hashKey(const uint64_t * key) const {
+  uint64_t hash = FNV_OFFSET;
+  for (size_t word = 0; word < width; word++) {
+    hash = (hash ^ key[word]) * FNV_PRIME;
+  }
+  return hash ^ (hash >> 32);
+}
+
+size_t StateSpace::intern(const uint64_t * key) {
+  if ((size() + 1) * 2 > slots.size()) {
+    std::vector<size_t> grown(slots.size() * 2, NO_STATE);
+    for (size_t state = 0; state < size(); state++) {
+      size_t idx = hashKey(&keys[state * width]) & (grown.size() - 1);
+      while (grown[idx] != NO_STATE) {
+        idx = (idx + 1) & (grown.size() - 1);
+      }
+      grown[idx] = state;
+    }
+    slots.swap(grown);
+  }
+  size_t idx = hashKey(key) & (slots.size() - 1);
+  while (slots[idx] != NO_STATE) {
+    if (std::equal(key, key + width, keys.begin() + slots[idx] * width)) {
+      return slots[idx];
+    }
+    idx = (idx + 1) & (slots.size() - 1);
+  }
+  slots[idx] = size();
+  keys.insert(keys.end(), key, key + width);
+  return slots[idx];
+}
+
+size_t StateSpace::intern(size_t pagenum, std::vector<long int> & memory) {
+  encode(pagenum, memory, &scratch[0]);
+  return intern(&scratch[0]);
+}
+
+size_t StateSpace::getPage(size_t state) const {
+  return keys[state * width];
+}
+
+void StateSpace::getMemory(size_t state, std::vector<long int> & memory) const {
+  memory.resize(values.size());
+  for (size_t var = 0; var < values.size(); var++) {
+    if (bits[var] == 0) {
+      memory[var] = values[var][0];
+      continue;
+    }
+    uint64_t idx = keys[state * width + words[var]] >> shifts[var];
+    if (bits[var] < 64) {
+      idx &= ((uint64_t)1 << bits[var]) - 1;
+    }
+    memory[var] = values[var][idx];
+  }
+}
+
+// CONDITIONAL PATHS
+void buildStateGraph(Story * story, std::vector<Page *> & pages, StateSpace & space,
+                     std::vector<size_t> & first, std::vector<size_t> & dests,
+                     std::vector<size_t> & choices) {
+  /*
+    Build every (page, memory) state reachable from page 0 under playCondStory rules,
+    with edges for the choices available in each state in choice order
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+    std::vector<Page *> & pages: Page for each page number
+    StateSpace & space: filled with reachable states in BFS order
+    std::vector<size_t> & first: filled with index of first edge of each state, and
+    number of edges at the end
+    std::vector<size_t> & dests: filled with destination state of each edge
+    std::vector<size_t> & choices: filled with choice number of each edge
+
+    Return
+    ------
+    None
+  */
+  std::vector<long int> memory = story->getMemory();
+  story->updateMemory(0, memory);
+  space.intern(0, memory);
+  std::vector<long int> next;
+  for (size_t state = 0; state < space.size(); state++) {
+    first.push_back(dests.size());
+    Page * page = pages[space.getPage(state)];
+    if (page->getPagetype().compare("N") != 0) {
+      continue;
+    }
+    space.getMemory(state, memory);
+    const std::vector<ChoiceCond> & conds = page->getConditions();
+    std::vector<ChoiceCond>::const_iterator condIt = conds.begin();
+    std::vector<size_t> & destpages = page->getDestpages();
+    for (size_t choice = 1; choice <= destpages.size(); choice++) {
+      if (condIt != conds.end() && condIt->choice == choice) {
+        bool available = page->doesMatchExist(memory, *condIt);
+        ++condIt;
+        if (!available) {
+          continue;
+        }
+      }
+      next = memory;
+      story->updateMemory(destpages[choice - 1], next);
+      dests.push_back(space.intern(destpages[choice - 1], next));
+      choices.push_back(choice);
+    }
+    if (space.size() > COND_MAX_STATES) {
+      std::cerr << "Too many states: more than " << COND_MAX_STATES
+                << " (page, memory) states are reachable" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  first.push_back(dests.size());
+}
+
+std::vector<bool> findStatesReaching(std::vector<size_t> & first,
+                                     std::vector<size_t> & dests,
+                                     std::vector<bool> & targets) {
+  /*
+    Return states from which a target state can be reached
+
+    Arguments
+    ---------
+    std::vector<size_t> & first: index of first edge of each state
+    std::vector<size_t> & dests: destination state of each edge
+    std::vector<bool> & targets: indicates target states
+
+    Return
+    ------
+    std::vector<bool> indicating for each state if a target can be reached from it
+  */
+  size_t numStates = first.size() - 1;
+  std::vector<size_t> predFirst(numStates + 1, 0);
+  for (size_t edge = 0; edge < dests.size(); edge++) {
+    predFirst[dests[edge] + 1]++;
+  }
+  for (size_t state = 0; state < numStates; state++) {
+    predFirst[state + 1] += predFirst[state];
+  }
+  std::vector<size_t> preds(dests.size());
+  std::vector<size_t> fill(predFirst.begin(), predFirst.end() - 1);
+  for (size_t state = 0; state < numStates; state++) {
+    for (size_t edge = first[state]; edge < first[state + 1]; edge++) {
+      preds[fill[dests[edge]]++] = state;
+    }
+  }
+  std::vector<bool> reach(targets);
+  std::vector<size_t> queue;
+  for (size_t state = 0; state < numStates; state++) {
+    if (reach[state]) {
+      queue.push_back(state);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    size_t state = queue[head];
+    for (size_t idx = predFirst[state]; idx < predFirst[state + 1]; idx++) {
+      if (!reach[preds[idx]]) {
+        reach[preds[idx]] = true;
+        queue.push_back(preds[idx]);
+      }
+    }
+  }
+  return reach;
+}
+
+size_t printStatePaths(StateSpace & space, std::vector<size_t> & first,
+                       std::vector<size_t> & dests, std::vector<size_t> & choices,
+                       size_t to, std::ostream & out) {
+  /*
+    Print playable paths to win page size_t to that never repeat a (page, memory)
+    state, in the same order as dfs, with the choice number taken on each page
+
+    Arguments
+    ---------
+    StateSpace & space: reachable states
+    std::vector<size_t> & first: index of first edge of each state
+    std::vector<size_t> & dests: destination state of each edge
+    std::vector<size_t> & choices: choice number of each edge
+    size_t to: number of win Page
+    std::ostream & out: stream to print paths to
+
+    Return
+    ------
+    size_t number of paths printed
+  */
+  size_t numStates = space.size();
+  std::vector<bool> targets(numStates, false);
+  for (size_t state = 0; state < numStates; state++) {
+    targets[state] = space.getPage(state) == to;
+  }
+  std::vector<bool> live = findStatesReaching(first, dests, targets);
+  if (numStates == 0 || !live[0]) {
+    return 0;
+  }
+  size_t numPaths = 0;
+  std::vector<char> onPath(numStates, 0);
+  std::vector<size_t> states(1, 0);
+  std::vector<size_t> edges;
+  // dfs explores choices last to first
+  std::vector<size_t> remaining(1, first[1] - first[0]);
+  onPath[0] = 1;
+  while (!states.empty()) {
+    size_t state = states.back();
+    if (targets[state] && remaining.back() == first[state + 1] - first[state]) {
+      for (size_t i = 0; i < edges.size(); i++) {
+        out << space.getPage(states[i]) << "(" << choices[edges[i]] << "),";
+      }
+      out << to << "(win)\n";
+      numPaths++;
+    }
+    if (remaining.back() == 0) {
+      onPath[state] = 0;
+      states.pop_back();
+      remaining.pop_back();
+      if (!edges.empty()) {
+        edges.pop_back();
+      }
+      continue;
+    }
+    size_t edge = first[state] + --remaining.back();
+    size_t dest = dests[edge];
+    if (onPath[dest] || !live[dest]) {
+      continue;
+    }
+    onPath[dest] = 1;
+    states.push_back(dest);
+    edges.push_back(edge);
+    remaining.push_back(first[dest + 1] - first[dest]);
+  }
+  return numPaths;
+}
+
+void printCondPaths(Story * story) {
+  /*
+    Print all playable winnable paths in conditional Story for all Win Page(s),
+    following variable assignments and only taking choices that are available
+    when they are made
+      - each step prints the choice actually taken, so where several choices lead
+        to the same page the path may differ from cyoa-step3, which always prints
+        the first of them (getChoiceNum)
+
+    Arguments
+    ---------
+    Story * story: pointer to Choose-Your-Own-Adventure Story
+
+    Return
+    ------
+    None
+  */
+  checkStory(story);
+  std::vector<Page *> pages = indexPages(story);
+  StateSpace space(story);
+  std::vector<size_t> first;
+  std::vector<size_t> dests;
+  std::vector<size_t> choices;
+  buildStateGraph(story, pages, space, first, dests, choices);
+  std::string win("W");
+  std::set<size_t> winpages = story->getPagetypes(win);
+  size_t numPaths = 0;
+  std::set<size_t>::iterator it = winpages.begin();
+  while (it != winpages.end()) {
+    numPaths += printStatePaths(space, first, dests, choices, *it, std::cout);
+    ++it;
+  }
+  if (numPaths == 0) {
+    std::cout << "This story is unwinnable!\n";
+  }
+  std::cout.flush();
+}
+
+// MODEL CHECKING
+void * runCheckShard(void * arg) {
+  /*
+    Expand states of one slice of the BFS frontier: record the key of the state each
+    available choice leads to, the choices that are available, and states where no
+    choice is available
+
+    Arguments
+    ---------
+    void * arg: pointer to CheckShard with story, state space, and frontier slice
+
+    Return
+    ------
+    NULL
+  */
+  CheckShard * shard = (CheckShard *)arg;
+  StateSpace & space = *shard->space;
+  size_t width = space.getWidth();
+  std::vector<long int> memory;
+  std::vector<long int> next;
+  shard->keys.clear();
+  shard->sources.clear();
+  shard->choices.clear();
+  shard->deadlocks.clear();
+  for (size_t idx = shard->begin; idx < shard->end; idx++) {
+    size_t state = (*shard->frontier)[idx];
+    size_t pagenum = space.getPage(state);
+    Page * page = (*shard->pages)[pagenum];
+    if (page->getPagetype().compare("N") != 0) {
+      continue;
+    }
+    space.getMemory(state, memory);
+    const std::vector<ChoiceCond> & conds = page->getConditions();
+    std::vector<ChoiceCond>::const_iterator condIt = conds.begin();
+    std::vector<size_t> & destpages = page->getDestpages();
+    bool stuck = true;
+    for (size_t choice = 1; choice <= destpages.size(); choice++) {
+      if (condIt != conds.end() && condIt->choice == choice) {
+        bool available = page->doesMatchExist(memory, *condIt);
+        ++condIt;
+        if (!available) {
+          continue;
+        }
+      }
+      stuck = false;
+      shard->enabled[(*shard->choiceBase)[pagenum] + choice - 1] = 1;
+      next = memory;
+      shard->story->updateMemory(destpages[choice - 1], next);
+      shard->keys.resize(shard->keys.size() + width);
+      space.encode(destpages[choice - 1], next, &shard->keys[shard->keys.size() - width]);
+      shard->sources.push_back(state);
+      shard->choices.push_back(choice);
+    }
+    if (stuck) {
+      shard->deadlocks.push_back(state);
+    }
+  }
+  return NULL;
+}
+
+void printStatePath(StateSpace & space, std::vector<size_t> & parents,
+                    std::vector<size_t> & parentChoices, size_t state,
+                    std::ostream & out) {
+  /*
+    Print shortest path from page 0 to state found by BFS, with the choice number
+    taken on each page
+
+    Arguments
+    ---------
+    StateSpace & space: reachable states
+    std::vector<size_t> & parents: state each state was first reached from
+    std::vector<size_t> & parentChoices: choice taken to first reach each state
+    size_t state: state to print path to
+    std::ostream & out: stream to print path to
+
+    Return
+    ------
+    None
+  */
+  std::vector<size_t> states(1, state);
+  while (parents[states.back()] != NO_STATE) {
+    states.push_back(parents[states.back()]);
+  }
+  for (size_t i = states.size() - 1; i > 0; i--) {
+    out << space.getPage(states[i]) << "(" << parentChoices[states[i - 1]] << "),";
+  }
+  out << space.getPage(state) << "\n";
+}
+
+bool modelCheckStory(int argc, char ** argv) {
+  /*
+    Explore every (page, memory) state of conditional Story reachable from page 0 with
+    a BFS whose frontier is expanded across threads, and print choices that are never
+    available, pages never reached, and pages where no choice is available, each
+    with an example path
+
+    Arguments
+    ---------
+    int argc: number of command line arguments
+    char ** argv: pointer to array with command line arguments
+      - argv[1]: directory with story.txt file
+      - argv[2]: number of threads (optional, default number of processors)
+
+    Return
+    ------
+    bool true if no problem was found
+  */
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: ./cyoa-check <dir> [threads]\n";
+    exit(EXIT_FAILURE);
+  }
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t numThreads = argc > 2 ? parseCount(argv[2]) : (cpus > 0 ? cpus : 1);
+  numThreads = std::max((size_t)1, numThreads);
+  Story * story = buildCondStory(argv[1]);
+  checkStory(story);
+  std::vector<Page *> pages = indexPages(story);
+  std::vector<size_t> choiceBase(pages.size() + 1, 0);
+  for (size_t pagenum = 0; pagenum < pages.size(); pagenum++) {
+    size_t numChoices = pages[pagenum] == NULL ? 0 : pages[pagenum]->getDestpages().size();
+    choiceBase[pagenum + 1] = choiceBase[pagenum] + numChoices;
+  }
+  StateSpace space(story);
+  std::vector<long int> memory = story->getMemory();
+  story->updateMemory(0, memory);
+  space.intern(0, memory);
+  std::vector<size_t> parents(1, NO_STATE);
+  std::vector<size_t> parentChoices(1, 0);
+  std::vector<size_t> deadlocks;
+  std::vector<size_t> frontier(1, 0);
+  std::vector<CheckShard> shards(numThreads);
+  for (size_t i = 0; i < numThreads; i++) {
+    shards[i].story = story;
+    shards[i].pages = &pages;
+    shards[i].space = &space;
+    shards[i].frontier = &frontier;
+    shards[i].choiceBase = &choiceBase;
+    shards[i].enabled.assign(choiceBase.back(), 0);
+  }
+  std::vector<pthread_t> threads(numThreads);
+  while (!frontier.empty()) {
+    size_t numShards = frontier.size() < CHECK_MIN_PARALLEL ? 1 : numThreads;
+    for (size_t i = 0; i < numShards; i++) {
+      shards[i].begin = frontier.size() * i / numShards;
+      shards[i].end = frontier.size() * (i + 1) / numShards;
+    }
+    if (numShards == 1) {
+      runCheckShard(&shards[0]);
+    }
+    else {
+      for (size_t i = 0; i < numShards; i++) {
+        if (pthread_create(&threads[i], NULL, runCheckShard, &shards[i]) != 0) {
+          std::cerr << "Failed to start model checking thread" << std::endl;
+          exit(EXIT_FAILURE);
+        }
+      }
+      for (size_t i = 0; i < numShards; i++) {
+        pthread_join(threads[i], NULL);
+      }
+    }
+    // intern in frontier order so states and example paths do not depend on threads
+    std::vector<size_t> next;
+    size_t width = space.getWidth();
+    for (size_t i = 0; i < numShards; i++) {
+      for (size_t idx = 0; idx < shards[i].sources.size(); idx++) {
+        size_t state = space.intern(&shards[i].keys[idx * width]);
+        if (state == parents.size()) {
+          parents.push_back(shards[i].sources[idx]);
+          parentChoices.push_back(shards[i].choices[idx]);
+          next.push_back(state);
+        }
+      }
+      deadlocks.insert(deadlocks.end(), shards[i].deadlocks.begin(),
+                       shards[i].deadlocks.end());
+    }
+    if (space.size() > COND_MAX_STATES) {
+      std::cerr << "Too many states: more than " << COND_MAX_STATES
+                << " (page, memory) states are reachable" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    frontier.swap(next);
+  }
+  // first state reached on each page, which has a shortest example path
+  std::vector<size_t> firstState(pages.size(), NO_STATE);
+  for (size_t state = space.size(); state > 0; state--) {
+    firstState[space.getPage(state - 1)] = state - 1;
+  }
+  size_t numProblems = 0;
+  for (size_t pagenum = 0; pagenum < pages.size(); pagenum++) {
+    if (pages[pagenum] == NULL) {
+      continue;
+    }
+    if (firstState[pagenum] == NO_STATE) {
+      std::cout << "Unreachable Page: page " << pagenum << " is never reached\n";
+      numProblems++;
+      continue;
+    }
+    for (size_t choice = 1; choice <= pages[pagenum]->getDestpages().size(); choice++) {
+      bool enabled = false;
+      for (size_t i = 0; i < numThreads; i++) {
+        enabled = enabled || shards[i].enabled[choiceBase[pagenum] + choice - 1];
+      }
+      if (!enabled) {
+        std::cout << "Dead Choice: page " << pagenum << " choice " << choice
+                  << " is never available\n  example: ";
+        printStatePath(space, parents, parentChoices, firstState[pagenum], std::cout);
+        numProblems++;
+      }
+    }
+  }
+  std::vector<bool> reported(pages.size(), false);
+  const std::vector<std::string> & names = story->getVarNames();
+  std::vector<size_t>::iterator it = deadlocks.begin();
+  while (it != deadlocks.end()) {
+    size_t pagenum = space.getPage(*it);
+    if (!reported[pagenum]) {
+      reported[pagenum] = true;
+      std::cout << "Deadlock: page " << pagenum << " has no available choice";
+      space.getMemory(*it, memory);
+      for (size_t var = 0; var < names.size(); var++) {
+        std::cout << (var == 0 ? " with " : " ") << names[var] << "=" << memory[var];
+      }
+      std::cout << "\n  example: ";
+      printStatePath(space, parents, parentChoices, *it, std::cout);
+      numProblems++;
+    }
+    ++it;
+  }
+  if (numProblems == 0) {
+    std::cout << "No dead choices or deadlocks in " << space.size() << " states\n";
+  }
+  std::cout.flush();
+  delete story;
+  return numProblems == 0;
+}
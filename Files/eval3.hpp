@@ -1,10 +1,21 @@
 #include <ctype.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <exception>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <set>
@@ -15,6 +26,26 @@
 #include <utility>
 #include <vector>
 
+// CHOICE CONDITION
+#define NO_VAR ((size_t)-1)
+#define COND_EQ 0
+#define COND_NE 1
+#define COND_LT 2
+#define COND_GT 3
+#define COND_AND 4
+#define COND_OR 5
+#define COND_STACK_SIZE 4
+struct CondOp {
+  int opcode;
+  size_t var;
+  long int value;
+};
+struct ChoiceCond {
+  size_t choice;
+  size_t first;
+  size_t last;
+};
+
 // PAGE CLASS
 class Page {
   size_t pagenum;
@@ -24,7 +55,8 @@ class Page {
   std::string closing;
   std::vector<std::string> choices;
   std::vector<size_t> destpages;
-  std::map<int, std::pair<std::string, long int> > conditions;
+  std::vector<ChoiceCond> conditions;
+  std::vector<CondOp> code;
 
  public:
   Page();
@@ -51,23 +83,27 @@ class Page {
   std::vector<size_t> & getDestpages();
   const std::vector<size_t> & getDestpages() const;
   std::string toString() const;
-  std::map<int, std::pair<std::string, long int> > & getConditions();
-  const std::map<int, std::pair<std::string, long int> > & getConditions() const;
-  void setConditions(std::map<int, std::pair<std::string, long int> > & conds);
-  bool doesMatchExist(std::map<std::string, long int> & memory,
-                      std::string & var,
-                      long int val) const;
-  std::vector<std::string> process(std::map<std::string, long int> & memory) const;
-  std::vector<std::string> processChoices(std::map<std::string, long int> & memory) const;
-  std::set<size_t> getInvalidChoices(std::map<std::string, long int> & memory) const;
-  std::string toStringCond(std::map<std::string, long int> & memory) const;
+  std::vector<ChoiceCond> & getConditions();
+  const std::vector<ChoiceCond> & getConditions() const;
+  const std::vector<CondOp> & getCode() const;
+  void setConditions(std::vector<ChoiceCond> & conds, std::vector<CondOp> & ops);
+  bool doesMatchExist(std::vector<long int> & memory, const ChoiceCond & cond) const;
+  std::vector<std::string> process(std::vector<long int> & memory) const;
+  std::vector<std::string> processChoices(std::vector<long int> & memory) const;
+  std::set<size_t> getInvalidChoices(std::vector<long int> & memory) const;
+  std::string toStringCond(std::vector<long int> & memory) const;
 };
 
 // STORY CLASS
 class Story {
   std::map<size_t, Page *> pages;
   std::vector<std::string> vars;
-  std::map<std::string, long int> memory;
+  std::vector<std::string> varNames;
+  std::map<std::string, size_t> varIds;
+  std::vector<std::vector<std::pair<size_t, long int> > > assignments;
+  std::vector<long int> memory;
+  uint64_t validationKey;
+  bool validated;
 
  public:
   Story();
@@ -81,13 +117,201 @@ class Story {
   std::vector<std::string> & getVars();
   const std::vector<std::string> & getVars() const;
   void setVars(std::vector<std::string> & v);
-  std::vector<std::string> filterVars(size_t pagenum);
   std::string parseVar(std::string & str);
   long int parseVal(std::string & str);
+  const std::vector<std::string> & getVarNames() const;
+  size_t getVarId(const std::string & var) const;
   void buildMemory();
   void updateMemory(size_t pagenum);
-  std::map<std::string, long int> & getMemory();
-  const std::map<std::string, long int> & getMemory() const;
+  void updateMemory(size_t pagenum, std::vector<long int> & mem);
+  std::vector<long int> & getMemory();
+  const std::vector<long int> & getMemory() const;
+  uint64_t getValidationKey() const;
+  void setValidationKey(uint64_t key);
+  bool isValidated() const;
+  void setValidated(bool flag);
+};
+
+// PATH TRIE CLASS
+class PathTrie {
+  std::vector<size_t> pages;
+  std::vector<size_t> choices;
+  std::vector<size_t> ends;
+  std::vector<std::vector<size_t> > children;
+
+ public:
+  PathTrie();
+  ~PathTrie();
+  size_t size() const;
+  size_t findChild(size_t node, size_t page) const;
+  void insert(Story * story, std::vector<size_t> & path);
+  void write(std::ostream & out) const;
+};
+
+// PATH ITERATOR CLASS
+class PathIterator {
+  Story * story;
+  std::vector<size_t> winpages;
+  size_t winIdx;
+  std::vector<size_t> path;
+  std::vector<size_t> remaining;
+  size_t emitted;
+
+ public:
+  PathIterator(Story * story);
+  ~PathIterator();
+  void push(size_t pagenum);
+  int next(std::vector<size_t> & out, size_t maxSteps);
+  size_t getEmitted() const;
+  bool isDone() const;
+  void save(std::ostream & out) const;
+  bool load(std::istream & in);
+};
+
+// STORY GRAPH CLASS
+#define NO_PAGE ((size_t)-1)
+class StoryGraph {
+  std::vector<size_t> external;
+  std::vector<size_t> internal;
+  std::vector<char> types;
+  std::vector<size_t> first;
+  std::vector<size_t> dests;
+  std::vector<size_t> predFirst;
+  std::vector<size_t> preds;
+  std::vector<size_t> invalidRefs;
+
+ public:
+  StoryGraph(Story * story);
+  ~StoryGraph();
+  size_t size() const;
+  size_t toExternal(size_t node) const;
+  size_t toInternal(size_t pagenum) const;
+  char getType(size_t node) const;
+  size_t firstEdge(size_t node) const;
+  size_t lastEdge(size_t node) const;
+  size_t getDest(size_t edge) const;
+  size_t firstPred(size_t node) const;
+  size_t lastPred(size_t node) const;
+  size_t getPred(size_t idx) const;
+  const std::vector<size_t> & getInvalidRefs() const;
+};
+
+// PATH QUERY CLASS
+class PathQuery {
+  std::vector<char> avoided;
+  std::vector<size_t> required;
+  size_t numRequired;
+  size_t words;
+  std::vector<uint64_t> reach;
+
+ public:
+  PathQuery(const StoryGraph & graph,
+            std::vector<size_t> & must,
+            std::vector<size_t> & avoid);
+  ~PathQuery();
+  bool isEmpty() const;
+  bool isAvoided(size_t node) const;
+  size_t getRequired(size_t node) const;
+  std::vector<uint64_t> getPending() const;
+  bool canReach(size_t node, const std::vector<uint64_t> & pending) const;
+};
+
+// CHAIN GRAPH CLASS
+class ChainGraph {
+  StoryGraph graph;
+  std::vector<size_t> first;
+  std::vector<size_t> dests;
+  std::vector<size_t> viaFirst;
+  std::vector<size_t> via;
+
+ public:
+  ChainGraph(Story * story);
+  ~ChainGraph();
+  size_t numEdges() const;
+  const StoryGraph & getGraph() const;
+  size_t printPaths(Story * story,
+                    size_t to,
+                    std::ostream & out,
+                    const PathQuery * query = NULL) const;
+};
+
+// SUBGRAPH CLASSES CLASS
+#define NO_CLASS ((size_t)-1)
+class SubgraphClasses {
+  std::vector<size_t> classOf;
+  std::vector<long double> counts;
+  std::vector<size_t> liveFirst;
+  std::vector<size_t> live;
+
+ public:
+  SubgraphClasses(Story * story);
+  ~SubgraphClasses();
+  size_t numClasses() const;
+  size_t getClass(size_t pagenum) const;
+  long double countPaths(Story * story) const;
+  size_t printPaths(Story * story, std::ostream & out) const;
+};
+
+// HINT TABLE CLASS
+#define NO_HINT ((uint32_t)-1)
+class HintTable {
+  std::vector<uint32_t> distances;
+  std::vector<uint32_t> choices;
+
+ public:
+  HintTable(Story * story);
+  ~HintTable();
+  bool hasHint(size_t pagenum) const;
+  size_t getChoice(size_t pagenum) const;
+  size_t getDistance(size_t pagenum) const;
+};
+
+// PATH ZDD CLASS
+#define ZDD_INTERIOR (-3L)
+#define ZDD_TO_WIN (-2L)
+#define ZDD_FROM_START (-1L)
+class PathZdd {
+  std::vector<size_t> vars;
+  std::vector<size_t> los;
+  std::vector<size_t> his;
+  std::map<std::pair<size_t, std::pair<size_t, size_t> >, size_t> unique;
+  size_t root;
+
+ public:
+  PathZdd(StoryGraph & graph);
+  ~PathZdd();
+  size_t getRoot() const;
+  size_t size(size_t node) const;
+  size_t makeNode(size_t var, size_t lo, size_t hi);
+  std::string count(size_t node) const;
+  bool contains(size_t node, std::vector<size_t> & edges) const;
+  size_t filter(size_t node, std::vector<char> & marked, bool keep);
+  void printPaths(Story * story, StoryGraph & graph, size_t node, std::ostream & out) const;
+};
+
+// STATE SPACE CLASS
+#define NO_STATE ((size_t)-1)
+class StateSpace {
+  std::vector<std::vector<long int> > values;
+  std::vector<size_t> words;
+  std::vector<size_t> shifts;
+  std::vector<size_t> bits;
+  size_t width;
+  std::vector<uint64_t> keys;
+  std::vector<size_t> slots;
+  std::vector<uint64_t> scratch;
+
+ public:
+  StateSpace(Story * story);
+  ~StateSpace();
+  size_t size() const;
+  size_t getWidth() const;
+  void encode(size_t pagenum, std::vector<long int> & memory, uint64_t * key) const;
+  uint64_t hashKey(const uint64_t * key) const;
+  size_t intern(const uint64_t * key);
+  size_t intern(size_t pagenum, std::vector<long int> & memory);
+  size_t getPage(size_t state) const;
+  void getMemory(size_t state, std::vector<long int> & memory) const;
 };
 
 // ERROR HANDLING
@@ -107,12 +331,11 @@ void checkStoryFile(std::vector<std::string> & lines);
 std::set<size_t> findNormalpages(std::vector<std::string> & lines);
 void checkMembership(std::set<size_t> & members, std::vector<std::string> & candidates);
 void checkEndPages(std::pair<std::vector<std::string>, std::vector<std::string> > & data);
-std::set<size_t> addDestpages(std::set<size_t> & members,
-                              std::vector<size_t> & candidates);
-void helpInvalidRefs(std::map<size_t, Page *> & pages, std::set<size_t> & references);
-void checkInvalidRefs(Story * story);
-void helpMissingRefs(std::map<size_t, Page *> & pages, std::set<size_t> & references);
-void checkMisingRefs(Story * story);
+void checkInvalidRefs(StoryGraph & graph);
+void checkMissingRefs(StoryGraph & graph);
+std::vector<bool> findReachable(StoryGraph & graph);
+std::vector<bool> findCoreachable(StoryGraph & graph);
+void checkReachability(StoryGraph & graph);
 void checkNumEndPages(Story * story);
 void checkStory(Story * story);
 int checkVarValue(std::string & str);
@@ -124,9 +347,13 @@ void checkCondStory(std::vector<std::string> & lines);
 std::string checkDir(char * dir);
 std::string buildPath(char * dir, std::string & file);
 std::string getPath(int numArgs, char ** inputs, std::string & file);
-std::vector<std::string> readInfile(std::string & path, std::string & file, bool flag);
+std::vector<std::string> readInfile(std::string & path,
+                                    std::string & file,
+                                    bool flag,
+                                    bool check = true);
 std::pair<std::vector<std::string>, std::vector<std::string> > parseStoryFile(
-    std::vector<std::string> & lines);
+    std::vector<std::string> & lines,
+    bool check = true);
 size_t getPagenum(std::string & str);
 std::string getPagetype(std::string & str);
 std::string getFile(std::string & str);
@@ -147,33 +374,266 @@ std::map<size_t, Page *> buildPages(char * dir,
                                     std::vector<std::string> & declarations,
                                     std::vector<std::string> & choices);
 Story * buildStory(int argc, char ** argv);
+Story * buildStory(char * dir);
 void printStory(Story * story);
 void initStory(Story * story);
 void playStory(Story * story);
+void printHint(HintTable & hints, size_t pagenum);
 int getFrequency(std::vector<size_t> & currentPath, size_t currentNode);
 std::map<int, std::vector<size_t> > dfs(Story * story, size_t from, size_t to);
 std::map<int, std::map<int, std::vector<size_t> > > runDFS(Story * story);
 size_t getChoiceNum(Page * page, size_t destpage);
 void printPath(Story * story, std::vector<size_t> & pages);
+void printPath(Story * story, std::vector<size_t> & pages, std::ostream & out);
 void printPagePaths(Story * story, std::map<int, std::vector<size_t> > & paths);
 bool doesPathExit(std::map<int, std::map<int, std::vector<size_t> > > & allPaths);
 void printAllPaths(Story * story);
-std::vector<std::string> readCondFile(std::string & path, std::string & file, bool flag);
+void printAllPaths(Story * story, std::vector<size_t> & must, std::vector<size_t> & avoid);
+void printQueryPaths(int argc, char ** argv);
+bool parseConstraint(char * arg, std::vector<size_t> & must, std::vector<size_t> & avoid);
+void checkConstraints(Story * story,
+                      std::vector<size_t> & must,
+                      std::vector<size_t> & avoid);
+std::vector<std::string> readCondFile(std::string & path,
+                                      std::string & file,
+                                      bool flag,
+                                      bool check = true);
 void checkParsing(std::map<std::string, std::vector<std::string> > & data);
 std::map<std::string, std::vector<std::string> > parseCondStory(
-    std::vector<std::string> & lines);
+    std::vector<std::string> & lines,
+    bool check = true);
 std::string getVariable(std::string & str, std::string & substr);
 long int getValue(std::string & str);
-std::map<int, std::pair<std::string, long int> > parseConditions(
-    std::vector<std::string> & choices);
+std::map<std::string, size_t> indexVars(std::vector<std::string> & vars,
+                                        std::vector<std::string> & names);
+std::string trimSpaces(const std::string & str);
+bool compileComparison(std::string & term,
+                       std::map<std::string, size_t> & varIds,
+                       std::vector<CondOp> & code);
+bool compileCondition(std::string & expr,
+                      std::map<std::string, size_t> & varIds,
+                      std::vector<CondOp> & code);
+std::vector<ChoiceCond> parseConditions(std::vector<std::string> & choices,
+                                        std::map<std::string, size_t> & varIds,
+                                        std::vector<CondOp> & code);
 Page * matchCondChoices(size_t pagenum,
                         std::string & pagetype,
                         std::string & file,
                         std::vector<std::string> & text,
                         std::string & closing,
-                        std::vector<std::string> & choices);
+                        std::vector<std::string> & choices,
+                        std::map<std::string, size_t> & varIds);
 std::map<size_t, Page *> buildCondPages(char * dir,
                                         std::vector<std::string> & declarations,
-                                        std::vector<std::string> & choices);
+                                        std::vector<std::string> & choices,
+                                        std::map<std::string, size_t> & varIds);
 Story * buildCondStory(int argc, char ** argv);
+Story * buildCondStory(char * dir);
 void playCondStory(Story * story);
+
+// PATH TRIE
+void printPathTrie(Story * story);
+void printTriePath(std::ostream & out,
+                   std::vector<size_t> & pages,
+                   std::vector<size_t> & choices);
+void decodePathTrie(std::istream & in, std::ostream & out);
+void printDecodedTrie(int argc, char ** argv);
+
+// RESUMABLE PATHS
+#define CHECKPOINT_SECONDS 30
+#define CHECKPOINT_STEPS 1000000
+void saveCursor(PathIterator & cursor, std::string & file);
+void loadCursor(PathIterator & cursor, std::string & file);
+void printResumedPaths(int argc, char ** argv);
+
+// PATH CACHE
+#define FNV_OFFSET 0xcbf29ce484222325UL
+#define FNV_PRIME 0x100000001b3UL
+#define CACHE_TAIL 64
+#define CACHE_BLOCK 65536
+uint64_t hashStory(Story * story);
+uint64_t hashString(const std::string & str);
+std::string getCacheDir();
+std::string getCacheFile(uint64_t hash, const std::string & suffix);
+std::string getTempFile(const std::string & file);
+bool printCachedPaths(std::string & file, uint64_t hash);
+size_t writeCachedPaths(Story * story, std::string & file, uint64_t hash);
+void printAllPathsCached(Story * story);
+
+// VALIDATION CACHE
+// bump whenever checkStory, checkStoryFile, or checkCondStory changes
+#define VALIDATION_VERSION 2
+uint64_t hashValidation(char * dir, std::vector<std::string> & lines, std::string & mode);
+bool isValidated(uint64_t key);
+void saveValidation(uint64_t key);
+
+// SHARED SUBGRAPHS
+void printSharedPaths(int argc, char ** argv);
+
+// DOMINATORS
+std::vector<size_t> findDominators(StoryGraph & graph);
+void printDominators(Story * story);
+
+// MARKOV CHAIN
+#define MARKOV_TOLERANCE 1e-12
+#define MARKOV_MAX_ITER 100000
+std::map<std::pair<size_t, size_t>, double> readChoiceStats(char * file);
+std::vector<double> buildTransitions(StoryGraph & graph,
+                                     std::map<std::pair<size_t, size_t>, double> & stats);
+void checkAbsorbing(StoryGraph & graph, std::vector<double> & probs);
+size_t solveMarkovChain(StoryGraph & graph,
+                        std::vector<double> & probs,
+                        std::vector<double> & winProb,
+                        std::vector<double> & expected);
+void printMarkovChain(int argc, char ** argv);
+
+// SIMULATION
+#define SIM_DEFAULT_RUNS 1000000
+#define SIM_MAX_STEPS 10000
+struct SimShard {
+  Story * story;
+  std::vector<Page *> * pages;
+  size_t begin;
+  size_t end;
+  uint64_t seed;
+  size_t wins;
+  size_t losses;
+  size_t stuck;
+  size_t unfinished;
+  std::vector<size_t> lengths;
+  std::vector<size_t> visits;
+};
+uint64_t seedRandom(uint64_t seed);
+uint64_t nextRandom(uint64_t & state);
+size_t randomIndex(uint64_t & state, size_t bound);
+size_t parseCount(char * arg);
+std::vector<Page *> indexPages(Story * story);
+void * runSimShard(void * arg);
+void simulateStory(int argc, char ** argv);
+
+// REPLAY
+struct Replay {
+  size_t line;
+  std::vector<std::string> inputs;
+  size_t endPage;
+  std::map<std::string, long int> memory;
+  bool passed;
+  std::string result;
+  std::string output;
+};
+struct ReplayShard {
+  Story * story;
+  std::vector<Page *> * pages;
+  std::vector<Replay> * replays;
+  size_t index;
+  size_t numShards;
+  bool render;
+};
+std::vector<Replay> readReplays(char * file);
+void runReplay(Story * story, std::vector<Page *> & pages, Replay & replay, bool render);
+void * runReplayShard(void * arg);
+bool replayStory(int argc, char ** argv);
+
+// EDGE COVER
+#define COVER_SEARCH_LIMIT 1024
+std::vector<size_t> findEndEdges(StoryGraph & graph);
+size_t findUncovered(StoryGraph & graph, std::vector<size_t> & uncovered, size_t from,
+                     std::vector<size_t> & seen, size_t stamp,
+                     std::vector<size_t> & route);
+std::vector<std::vector<size_t> > findEdgeCover(StoryGraph & graph);
+void printPlaythrough(StoryGraph & graph, std::vector<size_t> & edges, std::ostream & out);
+void printEdgeCover(Story * story);
+
+// PATH SAMPLING
+#define SAMPLE_DEFAULT_PATHS 1000
+#define SAMPLE_MAX_CELLS ((size_t)1 << 23)
+#define SAMPLE_MAX_TRIES 10000000
+#define SAMPLE_PILOT_WALKS 1000
+#define SAMPLE_MIN_ACCEPT 0.01
+bool findTopoOrder(StoryGraph & graph, std::vector<size_t> & order);
+std::vector<long double> countWalks(StoryGraph & graph, size_t rows);
+bool sampleWalk(StoryGraph & graph, std::vector<long double> & counts, size_t budget,
+                uint64_t & state, std::vector<size_t> & pages);
+void printSampledPaths(int argc, char ** argv);
+
+// PATH ESTIMATE
+#define ESTIMATE_SECONDS 10
+#define ESTIMATE_BATCH 1024
+std::vector<bool> findWinReachable(StoryGraph & graph);
+long double probePaths(StoryGraph & graph, std::vector<bool> & live, uint64_t & state,
+                       std::vector<char> & onPath, std::vector<size_t> & edges);
+void printPathEstimate(int argc, char ** argv);
+
+// PATH ZDD
+size_t takeZddEdge(StoryGraph & graph, std::vector<size_t> & current, size_t from,
+                   size_t to, std::vector<long> & in, std::vector<long> & out,
+                   std::vector<long> & mate);
+size_t leaveZddFrontier(StoryGraph & graph, std::vector<size_t> & current,
+                        std::vector<size_t> & leaving, std::vector<long> & in,
+                        std::vector<long> & out, std::vector<long> & mate);
+bool parseZddPath(StoryGraph & graph, std::string & line, std::vector<size_t> & edges);
+void printZddPaths(int argc, char ** argv);
+
+// SHARDED PATHS
+#define SHARD_UNITS_PER_WORKER 16
+std::vector<std::vector<size_t> > splitPaths(StoryGraph & graph, size_t numUnits);
+size_t printPrefixPaths(Story * story, StoryGraph & graph, std::vector<size_t> & choices,
+                        size_t to, std::ostream & out);
+void writeManifest(char * file, char * dir, uint64_t hash, size_t numShards,
+                   std::vector<std::vector<size_t> > & units);
+void readManifest(char * file, std::string & dir, uint64_t & hash, size_t & numShards,
+                  std::vector<std::vector<size_t> > & units, std::vector<size_t> & owners);
+std::string getShardFile(char * manifest, size_t shard);
+void runShard(Story * story, StoryGraph & graph, std::vector<std::vector<size_t> > & units,
+              std::vector<size_t> & owners, size_t shard, std::string & file);
+void mergeShards(char * manifest, size_t numShards);
+void printShardedPaths(int argc, char ** argv);
+
+// INCREMENTAL PATHS
+void collectEdges(StoryGraph & graph, std::map<std::pair<size_t, size_t>, size_t> & edges,
+                  std::set<size_t> & winpages);
+bool readIncrState(char * file, uint64_t & hash,
+                   std::map<std::pair<size_t, size_t>, size_t> & edges,
+                   std::set<size_t> & winpages, std::vector<std::string> & paths);
+void writeIncrState(char * file, uint64_t hash,
+                    std::map<std::pair<size_t, size_t>, size_t> & edges,
+                    std::set<size_t> & winpages, std::vector<std::string> & paths);
+bool isPathIntact(StoryGraph & graph, std::string & path);
+void findTouchedPaths(StoryGraph & graph, std::vector<bool> & changed,
+                      std::vector<bool> & newWins, std::vector<std::string> & paths);
+void printIncrPaths(int argc, char ** argv);
+
+// CONDITIONAL PATHS
+#define COND_MAX_STATES ((size_t)1 << 24)
+void buildStateGraph(Story * story, std::vector<Page *> & pages, StateSpace & space,
+                     std::vector<size_t> & first, std::vector<size_t> & dests,
+                     std::vector<size_t> & choices);
+std::vector<bool> findStatesReaching(std::vector<size_t> & first,
+                                     std::vector<size_t> & dests,
+                                     std::vector<bool> & targets);
+size_t printStatePaths(StateSpace & space, std::vector<size_t> & first,
+                       std::vector<size_t> & dests, std::vector<size_t> & choices,
+                       size_t to, std::ostream & out);
+void printCondPaths(Story * story);
+
+// MODEL CHECKING
+#define CHECK_MIN_PARALLEL 256
+struct CheckShard {
+  Story * story;
+  std::vector<Page *> * pages;
+  StateSpace * space;
+  std::vector<size_t> * frontier;
+  std::vector<size_t> * choiceBase;
+  size_t begin;
+  size_t end;
+  std::vector<uint64_t> keys;
+  std::vector<size_t> sources;
+  std::vector<size_t> choices;
+  std::vector<size_t> deadlocks;
+  std::vector<char> enabled;
+};
+void * runCheckShard(void * arg);
+void printStatePath(StateSpace & space, std::vector<size_t> & parents,
+                    std::vector<size_t> & parentChoices, size_t state,
+                    std::ostream & out);
+bool modelCheckStory(int argc, char ** argv);